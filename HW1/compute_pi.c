@@ -7,7 +7,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
-#include <sys/time.h>
+#include "../common/timing.h"
 
 #define MAX_THREADS     8192
 
@@ -34,7 +34,6 @@ void *compute_pi (void *s) {
 
 int main(int argc, char *argv[]) {
 
-    struct timeval start, stop; 
     double computed_pi, error_pi, total_time;
     int total_hits = 0;
     int sample_points;
@@ -57,24 +56,28 @@ int main(int argc, char *argv[]) {
     pthread_attr_init(&attr);
     pthread_attr_setdetachstate(&attr,PTHREAD_CREATE_JOINABLE);
 
-    gettimeofday(&start, NULL); 
+    timing_begin("compute_pi");
+    timing_begin("create threads");
     for (i = 0; i < num_threads; i++) {
 	hits[i] = i;
 	status = pthread_create(&p_threads[i],&attr,compute_pi, (void *) &hits[i]); 
 	if (status != 0) 
 	    printf("Non-zero status when creating thread # %d\n", i);
     }
+    timing_end();
+    timing_begin("join threads");
     for (i = 0; i < num_threads; i++) {
 	pthread_join(p_threads[i], NULL);
 	total_hits += hits[i]; 
     }
-    gettimeofday(&stop, NULL); 
-    total_time = (stop.tv_sec-start.tv_sec)+0.000001*(stop.tv_usec-start.tv_usec);
+    timing_end();
+    total_time = timing_end();
 
     computed_pi = (4.0*total_hits)/sample_points;
     error_pi = fabs(3.14159265358979323846 - computed_pi)/3.14159265358979323846;
-    printf("Trials = %d, Threads = %4d, pi = %14.10f, error = %8.2e, time (sec) = %8.4f\n", 
+    printf("Trials = %d, Threads = %4d, pi = %14.10f, error = %8.2e, time (sec) = %.9f\n", 
 	    sample_points, num_threads, computed_pi, error_pi, total_time);
+    if (TIMING_REPORT) timing_report(stdout);
     pthread_attr_destroy(&attr);
 
 }
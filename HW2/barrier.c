@@ -11,13 +11,13 @@
 //
 // Sample execution and output:
 //   $ ./barrier.exe 16
-//   Threads = 16, barrier time (sec) =   1.0030
+//   Threads = 16, barrier time (sec) = 2.001539979	 timer resolution = 1.0000e-09 sec
 //
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 #include "csce435.h"
+#include "../common/timing.h"
 
 #define MAX_THREADS     65536
 
@@ -62,8 +62,7 @@ void *start_func(void *s) {
 // Main program - creates threads, each thread excutes barrier routine
 int main(int argc, char *argv[]) {
 
-    struct timespec start, stop; 
-    double total_time, time_res;
+    double total_time;
     int i; 
 
     if (argc != 2) {
@@ -86,26 +85,27 @@ int main(int argc, char *argv[]) {
     count = 0;
 
     // Create threads; each thread executes find_minimum
-    clock_gettime(CLOCK_REALTIME, &start); 
+    timing_begin("barrier");
+    timing_begin("create threads");
     for (i = 0; i < num_threads; i++) { 
 	thread_id[i] = i; 
 	pthread_create(&p_threads[i], &attr, start_func, (void *) &thread_id[i]); 
     }
+    timing_end();
     // Join threads
+    timing_begin("join threads");
     for (i = 0; i < num_threads; i++) {
 	pthread_join(p_threads[i], NULL);
     }
+    timing_end();
     // Print time taken
-    clock_gettime(CLOCK_REALTIME, &stop); 
-    total_time = (stop.tv_sec-start.tv_sec)
-	+0.000000001*(stop.tv_nsec-start.tv_nsec);
+    total_time = timing_end();
 
-    printf("Threads = %d, barrier time (sec) = %8.4f", 
+    printf("Threads = %d, barrier time (sec) = %.9f", 
 	    num_threads, total_time);
 
-    clock_getres(CLOCK_REALTIME, &stop); 
-    time_res = stop.tv_sec+0.000000001*stop.tv_nsec;
-    printf("\t timer resolution = %8.4e sec\n", time_res);
+    printf("\t timer resolution = %8.4e sec\n", timing_resolution());
+    if (TIMING_REPORT) timing_report(stdout);
 
     // Destroy mutex and attribute structures
     pthread_attr_destroy(&attr);
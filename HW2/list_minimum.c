@@ -10,13 +10,13 @@
 //
 // Sample execution and output ($ sign is the shell prompt):
 //  $ ./list_minimum.exe 1000000 9
-// Threads = 9, minimum = 148, time (sec) =   0.0013
+// Threads = 9, minimum = 1646, time (sec) = 0.001888563
 //
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
-#include <time.h>
+#include "../common/timing.h"
 
 #define MAX_THREADS     65536
 #define MAX_LIST_SIZE   268435456
@@ -77,8 +77,7 @@ void *find_minimum (void *s) {
 // the minimum value; assign minimum value to global variable called minimum
 int main(int argc, char *argv[]) {
 
-    struct timespec start, stop;
-    double total_time, time_res;
+    double total_time;
     int i, j; 
     int true_minimum;
 
@@ -120,28 +119,31 @@ int main(int argc, char *argv[]) {
     count = 0;
 
     // Create threads; each thread executes find_minimum
-    clock_gettime(CLOCK_REALTIME, &start);
+    timing_begin("find_minimum");
+    timing_begin("create threads");
     for (i = 0; i < num_threads; i++) {
 	thread_id[i] = i; 
 	pthread_create(&p_threads[i], &attr, find_minimum, (void *) &thread_id[i]); 
     }
+    timing_end();
     // Join threads
+    timing_begin("join threads");
     for (i = 0; i < num_threads; i++) {
 	pthread_join(p_threads[i], NULL);
     }
+    timing_end();
 
     // Compute time taken
-    clock_gettime(CLOCK_REALTIME, &stop);
-    total_time = (stop.tv_sec-start.tv_sec)
-	+0.000000001*(stop.tv_nsec-start.tv_nsec);
+    total_time = timing_end();
 
     // Check answer
     if (true_minimum != minimum) {
 	printf("Houston, we have a problem!\n"); 
     }
     // Print time taken
-    printf("Threads = %d, minimum = %d, time (sec) = %8.4f\n", 
+    printf("Threads = %d, minimum = %d, time (sec) = %.9f\n", 
 	    num_threads, minimum, total_time);
+    if (TIMING_REPORT) timing_report(stdout);
 
     // Destroy mutex and attribute structures
     pthread_attr_destroy(&attr);
@@ -10,13 +10,15 @@
 //
 // Sample execution and output ($ sign is the shell prompt):
 //  $ ./list_statistics.exe 1000000 9
-// Threads = 9, minimum = 148, time (sec) =   0.0013
+// true_mean 1073276363.909457
+// true_stddev 619980056.757558
+// Threads = 9, mean = 1073276363.909457, stddev = 619980056.757558, time (sec) = 0.004413619
 //
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
-#include <time.h>
+#include "../common/timing.h"
 
 #define MAX_THREADS     65536
 #define MAX_LIST_SIZE   268435456
@@ -149,8 +151,7 @@ void *find_statistics (void *s) {
 // the minimum value; assign minimum value to global variable called minimum
 int main(int argc, char *argv[]) {
 
-    struct timespec start, stop;
-    double total_time, time_res;
+    double total_time;
     int i, j; 
     
     if (argc != 3) {
@@ -197,20 +198,22 @@ int main(int argc, char *argv[]) {
     stddev = true_stddev;
    
     // Create threads; each thread executes find_statistics
-    clock_gettime(CLOCK_REALTIME, &start);
+    timing_begin("find_statistics");
+    timing_begin("create threads");
     for (i = 0; i < num_threads; i++) {
 	thread_id[i] = i; 
 	pthread_create(&p_threads[i], &attr, find_statistics, (void *) &thread_id[i]); 
     }
+    timing_end();
     // Join threads
+    timing_begin("join threads");
     for (i = 0; i < num_threads; i++) {
 	pthread_join(p_threads[i], NULL);
     }
+    timing_end();
 
     // Compute time taken
-    clock_gettime(CLOCK_REALTIME, &stop);
-    total_time = (stop.tv_sec-start.tv_sec)
-	+0.000000001*(stop.tv_nsec-start.tv_nsec);
+    total_time = timing_end();
 
     // Check answer
     
@@ -229,8 +232,9 @@ int main(int argc, char *argv[]) {
     printf("true_mean %Lf\n", true_mean);
     printf("true_stddev %Lf\n", true_stddev);
     // // Print time taken
-    printf("Threads = %d, mean = %Lf, stddev = %Lf, time (sec) = %8.4f\n", 
+    printf("Threads = %d, mean = %Lf, stddev = %Lf, time (sec) = %.9f\n", 
 	    num_threads, mean, stddev, total_time);
+    if (TIMING_REPORT) timing_report(stdout);
     // Destroy mutex and attribute structures
     pthread_attr_destroy(&attr);
     pthread_mutex_destroy(&lock_mean_count);
@@ -26,6 +26,7 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <time.h>
+#include "../common/timing.h"
 
 #include "drone.h"		// Do not remove
 struct timespec start, stop; 	// Do not remove
@@ -120,7 +121,7 @@ int main(int argc, char *argv[]) {
 
 //    print_drone_path(); 
 
-    clock_gettime(CLOCK_REALTIME, &start); 	// Do not remove
+    timing_read(&start); 			// Do not remove
 //start = clock();
 
     // Multithreaded code to find drone in the grid 
@@ -153,9 +154,8 @@ int main(int argc, char *argv[]) {
     // ...
 
     // Compute time taken
-    clock_gettime(CLOCK_REALTIME, &stop);			// Do not remove
-    total_time = (stop.tv_sec-start.tv_sec)			// Do not remove
-	+0.000000001*(stop.tv_nsec-start.tv_nsec);		// Do not remove
+    timing_read(&stop);					// Do not remove
+    total_time = timing_elapsed(&start, &stop);		// Do not remove
 //stop = clock();
 //total_time = (1.0*stop-start)/CLOCKS_PER_SEC;
 
@@ -0,0 +1,103 @@
+// Game of Drones - asynchronous probes
+//
+// Find the drone in a grid using a few probe loop threads that keep many
+// check_grid probes in flight (see drone_async.h) instead of one OS thread
+// per outstanding probe
+//
+// Warning: Return values of calls are not checked for error to keep
+// the code simple.
+//
+// Requires drone.h and drone_async.h to be in the same directory
+//
+// Compilation command on ADA:
+//
+//   module load intel/2017A
+//   icc -o drone_async.exe drone_async.c -lpthread -lrt
+//
+// Sample execution and output ($ sign is the shell prompt):
+//
+// $ ./drone_async.exe 128 0 1000000000 0 2 4096
+//   Drone = (65,113), success = 1, threads = 2, depth = 4096, probes = 12416, time (sec) = 4.002161190
+//
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "drone.h"
+#include "drone_async.h"
+#include "../common/timing.h"
+
+struct timespec start, stop;
+double total_time;
+unsigned int gridsize;
+
+int drone_found = 0;		// Set (once) by the probe that finds the drone
+unsigned int drone_x, drone_y; 	// Coordinates of drone (to be found)
+long num_probes = 0;		// Number of probes completed
+pthread_mutex_t lock_drone_location;	// Protects drone coordinates, num_probes
+
+// Probe callback: record drone location if the probe hit it
+void probe_done(unsigned int x, unsigned int y, int result, void *arg) {
+    (void) arg;
+    pthread_mutex_lock(&lock_drone_location);
+    num_probes++;
+    if ((result == 0) && !drone_found) {
+	drone_x = x;
+	drone_y = y;
+	drone_found = 1;
+    }
+    pthread_mutex_unlock(&lock_drone_location);
+}
+
+// -------------------------------------------------------------------------
+// Main program to find drone in a grid
+int main(int argc, char *argv[]) {
+    struct probe_loop loop;
+    unsigned int i, j;
+    int num_threads, depth, found;
+
+    if (argc != 7) {
+	printf("Need six integers as input \n");
+	printf("Use: <executable_name> <grid_size> <random_seed> <delay_nanosecs> <move_count> <num_threads> <depth>\n");
+	exit(0);
+    }
+
+    pthread_mutex_init(&lock_drone_location, NULL);
+    // Initialize grid
+    gridsize = abs((int) atoi(argv[argc-6]));
+    int seed = (int) atoi(argv[argc-5]);
+    int delay_nsecs = abs((int) atoi(argv[argc-4]));
+    int move_count = abs((int) atoi(argv[argc-3]));
+    num_threads = abs((int) atoi(argv[argc-2]));
+    depth = abs((int) atoi(argv[argc-1]));
+    initialize_grid(gridsize, seed, delay_nsecs, move_count);
+    gridsize = (unsigned int) get_gridsize();
+
+    timing_read(&start);
+
+    // Submit probes row by row; check_grid_async() blocks once depth
+    // probes are in flight, so the loop threads set the pace
+    probe_loop_init(&loop, depth);
+    probe_loop_start(&loop, num_threads);
+    found = 0;
+    for (i = 0; (i < gridsize) && !found; i++) {
+	for (j = 0; j < gridsize; j++) {
+	    check_grid_async(&loop, i, j, probe_done, NULL);
+	}
+	pthread_mutex_lock(&lock_drone_location);
+	found = drone_found;
+	pthread_mutex_unlock(&lock_drone_location);
+    }
+    probe_loop_stop(&loop);
+
+    // Compute time taken
+    timing_read(&stop);
+    total_time = timing_elapsed(&start, &stop);
+
+    // Check if drone found, print time taken
+    printf("Drone = (%u,%u), success = %d, threads = %d, depth = %d, probes = %ld, time (sec) = %.9f\n",
+	    drone_x, drone_y, check_drone_location(drone_x,drone_y),
+	    loop.num_threads, loop.depth, num_probes, total_time);
+
+    pthread_mutex_destroy(&lock_drone_location);
+}
@@ -0,0 +1,256 @@
+// Header file for drone_async.c
+//
+// Asynchronous probes of the grid: check_grid_async() submits a probe of
+// grid location (x,y) and returns immediately. The probe completes after
+// the same forced delay as check_grid(), but no thread sleeps on its
+// behalf. Pending probes are kept in a min-heap ordered by completion
+// time; the probe loop threads wait for the earliest deadline, evaluate
+// every probe that is due, and call the callback of each probe with the
+// value check_grid() would have returned.
+//
+// The number of probes in flight is bounded by the depth given to
+// probe_loop_init(), so probe throughput is set by the depth (roughly
+// depth/delay probes per second) rather than by the number of threads.
+//
+// Requires drone.h to be included first
+//
+// Contains following routines
+//
+//    probe_loop_init(struct probe_loop *loop, int depth)
+//	- initialize an event loop that allows up to depth probes in flight
+//
+//    probe_loop_start(struct probe_loop *loop, int num_threads)
+//	- start num_threads probe loop threads
+//
+//    check_grid_async(struct probe_loop *loop, unsigned int x,
+//                     unsigned int y, probe_callback callback, void *arg)
+//	- submit probe of grid location (x,y); blocks only if depth probes
+//	  are already in flight; may be called from a callback
+//
+//    probe_loop_drain(struct probe_loop *loop)
+//	- wait until all submitted probes have completed
+//
+//    probe_loop_stop(struct probe_loop *loop)
+//	- drain the loop, join its threads and release its resources
+//
+#ifndef DRONE_ASYNC_H
+#define DRONE_ASYNC_H
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define MAX_PROBE_THREADS	64	// Maximum no. of probe loop threads
+#define PROBE_BATCH		256	// Maximum no. of due probes evaluated
+					// per lock acquisition
+
+// Called when a probe completes; result is the value check_grid(x,y)
+// would have returned
+typedef void (*probe_callback)(unsigned int x, unsigned int y, int result, void *arg);
+
+struct probe {
+    struct timespec deadline;		// time at which the probe completes
+    unsigned int x, y;			// grid location probed
+    probe_callback callback;
+    void *arg;
+};
+
+struct probe_loop {
+    struct probe *heap;			// pending probes, min-heap on deadline
+    int heap_size;
+    int heap_capacity;
+    int depth;				// maximum no. of probes in flight
+    int in_flight;			// probes submitted but not yet completed
+    int stop;				// set to terminate the loop threads
+    int num_threads;
+    pthread_t threads[MAX_PROBE_THREADS];
+    pthread_mutex_t lock;		// Protects all of the above
+    pthread_cond_t cond_due;		// Signals a new earliest deadline
+    pthread_cond_t cond_space;		// Signals completion of probes
+};
+
+// -------------------------------------------------------------------------
+// Time and heap helpers
+
+static int timespec_before(const struct timespec *a, const struct timespec *b) {
+    return (a->tv_sec < b->tv_sec) ||
+	((a->tv_sec == b->tv_sec) && (a->tv_nsec < b->tv_nsec));
+}
+
+// Insert probe into heap; returns its position (0 if it is the earliest)
+static int probe_heap_push(struct probe_loop *loop, const struct probe *p) {
+    int i, parent;
+    if (loop->heap_size == loop->heap_capacity) {
+	loop->heap_capacity *= 2;
+	loop->heap = (struct probe *) realloc(loop->heap,
+		loop->heap_capacity*sizeof(struct probe));
+    }
+    i = loop->heap_size++;
+    while (i > 0) {
+	parent = (i-1)/2;
+	if (!timespec_before(&p->deadline, &loop->heap[parent].deadline)) break;
+	loop->heap[i] = loop->heap[parent];
+	i = parent;
+    }
+    loop->heap[i] = *p;
+    return i;
+}
+
+static struct probe probe_heap_pop(struct probe_loop *loop) {
+    struct probe top = loop->heap[0];
+    struct probe last = loop->heap[--loop->heap_size];
+    int i = 0, child;
+    while ((child = 2*i+1) < loop->heap_size) {
+	if ((child+1 < loop->heap_size) &&
+		timespec_before(&loop->heap[child+1].deadline, &loop->heap[child].deadline))
+	    child++;
+	if (!timespec_before(&loop->heap[child].deadline, &last.deadline)) break;
+	loop->heap[i] = loop->heap[child];
+	i = child;
+    }
+    loop->heap[i] = last;
+    return top;
+}
+
+// -------------------------------------------------------------------------
+// Probe loop
+
+// Probe loop thread: sleeps until the earliest deadline, then completes
+// all probes that are due (up to PROBE_BATCH at a time) outside the lock
+static void *probe_loop_thread(void *s) {
+    struct probe_loop *loop = (struct probe_loop *) s;
+    struct probe due[PROBE_BATCH];
+    struct timespec now;
+    int num_due, j;
+
+    pthread_mutex_lock(&loop->lock);
+    while (!loop->stop) {
+	if (loop->heap_size == 0) {
+	    pthread_cond_wait(&loop->cond_due, &loop->lock);
+	    continue;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (timespec_before(&now, &loop->heap[0].deadline)) {
+	    pthread_cond_timedwait(&loop->cond_due, &loop->lock, &loop->heap[0].deadline);
+	    continue;
+	}
+	num_due = 0;
+	while ((loop->heap_size > 0) && (num_due < PROBE_BATCH) &&
+		!timespec_before(&now, &loop->heap[0].deadline)) {
+	    due[num_due++] = probe_heap_pop(loop);
+	}
+	// More probes may be due; let another loop thread take them
+	if (loop->heap_size > 0) pthread_cond_signal(&loop->cond_due);
+	pthread_mutex_unlock(&loop->lock);
+
+	for (j = 0; j < num_due; j++) {
+	    due[j].callback(due[j].x, due[j].y, check_drone_path(due[j].x, due[j].y), due[j].arg);
+	}
+
+	pthread_mutex_lock(&loop->lock);
+	loop->in_flight -= num_due;
+	pthread_cond_broadcast(&loop->cond_space);
+    }
+    pthread_mutex_unlock(&loop->lock);
+    return NULL;
+}
+
+// Initialize probe loop that allows up to depth probes in flight
+void probe_loop_init(struct probe_loop *loop, int depth) {
+    pthread_condattr_t cond_attr;
+    loop->depth = (depth > 0) ? depth : 1;
+    loop->heap_capacity = loop->depth;
+    loop->heap = (struct probe *) malloc(loop->heap_capacity*sizeof(struct probe));
+    loop->heap_size = 0;
+    loop->in_flight = 0;
+    loop->stop = 0;
+    loop->num_threads = 0;
+    pthread_mutex_init(&loop->lock, NULL);
+    // Deadlines are on CLOCK_MONOTONIC, so the timed wait must be as well
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&loop->cond_due, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+    pthread_cond_init(&loop->cond_space, NULL);
+}
+
+// Start num_threads probe loop threads
+void probe_loop_start(struct probe_loop *loop, int num_threads) {
+    int i;
+    if (num_threads < 1) num_threads = 1;
+    if (num_threads > MAX_PROBE_THREADS) num_threads = MAX_PROBE_THREADS;
+    loop->num_threads = num_threads;
+    for (i = 0; i < num_threads; i++) {
+	pthread_create(&loop->threads[i], NULL, probe_loop_thread, (void *) loop);
+    }
+}
+
+// Returns 1 if the calling thread is one of the probe loop threads
+static int probe_loop_is_own_thread(struct probe_loop *loop) {
+    int i;
+    for (i = 0; i < loop->num_threads; i++) {
+	if (pthread_equal(pthread_self(), loop->threads[i])) return 1;
+    }
+    return 0;
+}
+
+// Submit probe of grid location (x,y); callback is called from a probe loop
+// thread once the forced delay has elapsed.
+// - Blocks while depth probes are in flight, except when called from a
+//   callback (a loop thread must never wait for itself)
+//
+void check_grid_async(struct probe_loop *loop, unsigned int x, unsigned int y,
+	probe_callback callback, void *arg) {
+    struct probe p;
+    clock_gettime(CLOCK_MONOTONIC, &p.deadline);
+    p.deadline.tv_sec += delay.tv_sec;
+    p.deadline.tv_nsec += delay.tv_nsec;
+    if (p.deadline.tv_nsec >= 1000000000) {
+	p.deadline.tv_sec++;
+	p.deadline.tv_nsec -= 1000000000;
+    }
+    p.x = x; p.y = y;
+    p.callback = callback;
+    p.arg = arg;
+
+    pthread_mutex_lock(&loop->lock);
+    if (!probe_loop_is_own_thread(loop)) {
+	while (loop->in_flight >= loop->depth) {
+	    pthread_cond_wait(&loop->cond_space, &loop->lock);
+	}
+    }
+    loop->in_flight++;
+    if (probe_heap_push(loop, &p) == 0) {
+	// New earliest deadline; wake a loop thread to wait for it instead
+	pthread_cond_signal(&loop->cond_due);
+    }
+    pthread_mutex_unlock(&loop->lock);
+}
+
+// Wait until all submitted probes have completed
+void probe_loop_drain(struct probe_loop *loop) {
+    pthread_mutex_lock(&loop->lock);
+    while (loop->in_flight > 0) {
+	pthread_cond_wait(&loop->cond_space, &loop->lock);
+    }
+    pthread_mutex_unlock(&loop->lock);
+}
+
+// Drain probe loop, join its threads and release its resources
+void probe_loop_stop(struct probe_loop *loop) {
+    int i;
+    probe_loop_drain(loop);
+    pthread_mutex_lock(&loop->lock);
+    loop->stop = 1;
+    pthread_cond_broadcast(&loop->cond_due);
+    pthread_mutex_unlock(&loop->lock);
+    for (i = 0; i < loop->num_threads; i++) {
+	pthread_join(loop->threads[i], NULL);
+    }
+    free(loop->heap);
+    pthread_mutex_destroy(&loop->lock);
+    pthread_cond_destroy(&loop->cond_due);
+    pthread_cond_destroy(&loop->cond_space);
+}
+
+#endif
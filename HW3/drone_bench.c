@@ -0,0 +1,259 @@
+// Game of Drones - search strategy benchmark
+//
+// Records one drone trajectory per grid size and replays it
+// deterministically (see drone_replay.h) against each search strategy for
+// each move count. Prints one CSV line per (strategy, grid size, move
+// count) with the number of probes issued, the median time to find the
+// drone over the trials, and the probe throughput; the time and throughput
+// are left empty if the search did not find the drone. Probe counts do not
+// depend on timing or on the machine, so they can be compared across
+// commits directly.
+//
+// Warning: Return values of calls are not checked for error to keep
+// the code simple.
+//
+// Requires drone_world.h and drone_replay.h to be in the same directory
+//
+// Compilation command on ADA:
+//
+//   module load intel/2017A
+//   icc -o drone_bench.exe drone_bench.c -lpthread -lrt
+//
+// Sample execution and output ($ sign is the shell prompt):
+//
+// $ ./drone_bench.exe 256,1024 0,100 44 5
+//   strategy,grid_size,move_count,seed,found,x,y,probes,steps_moved,time_sec,probes_per_sec
+//   row_major,256,0,44,0,0,0,65536,19,,
+//   spiral,256,0,44,0,0,0,65536,19,,
+//   stride,256,0,44,0,0,0,65536,17,,
+//   path_follow,256,0,44,1,208,198,52469,23,9.655770e-04,5.433953e+07
+//   ...
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "drone_world.h"
+#include "drone_replay.h"
+#include "../common/timing.h"
+
+#define MAX_LIST_LENGTH	64		// Maximum no. of grid sizes/move counts
+#define MAX_TRIALS	101
+
+// -------------------------------------------------------------------------
+// Search strategies
+
+// Probe cells row by row
+int search_row_major(struct replay *r, unsigned int *x, unsigned int *y) {
+    unsigned int n = r->traj->grid_size;
+    unsigned int i, j;
+    for (i = 0; i < n; i++) {
+	for (j = 0; j < n; j++) {
+	    if (replay_check_grid(r, i, j) == 0) {
+		*x = i; *y = j;
+		return 1;
+	    }
+	}
+    }
+    return 0;
+}
+
+// Probe cell (i,j) if it is on the grid; returns 1 if the drone is there
+static int probe_cell(struct replay *r, int i, int j, unsigned int *x, unsigned int *y) {
+    int n = r->traj->grid_size;
+    if ((i < 0) || (j < 0) || (i >= n) || (j >= n)) return 0;
+    if (replay_check_grid(r, i, j) != 0) return 0;
+    *x = i; *y = j;
+    return 1;
+}
+
+// Probe cells in square rings around the center of the grid
+int search_spiral(struct replay *r, unsigned int *x, unsigned int *y) {
+    int n = r->traj->grid_size;
+    int c = n/2;
+    int ring, k;
+    if (probe_cell(r, c, c, x, y)) return 1;
+    for (ring = 1; ring <= c; ring++) {
+	for (k = -ring; k <= ring; k++) {
+	    if (probe_cell(r, c-ring, c+k, x, y)) return 1;	// top side
+	    if (probe_cell(r, c+ring, c+k, x, y)) return 1;	// bottom side
+	}
+	for (k = -ring+1; k <= ring-1; k++) {
+	    if (probe_cell(r, c+k, c-ring, x, y)) return 1;	// left side
+	    if (probe_cell(r, c+k, c+ring, x, y)) return 1;	// right side
+	}
+    }
+    return 0;
+}
+
+// Probe cells in the scattered order k*stride mod n^2, with stride
+// coprime to n^2 so that every cell is visited exactly once
+static unsigned long gcd(unsigned long a, unsigned long b) {
+    while (b != 0) {
+	unsigned long t = a % b;
+	a = b; b = t;
+    }
+    return a;
+}
+
+int search_stride(struct replay *r, unsigned int *x, unsigned int *y) {
+    unsigned long n = r->traj->grid_size;
+    unsigned long cells = n*n;
+    unsigned long stride = (unsigned long) (0.618*cells) | 1;
+    unsigned long k, c;
+    while (gcd(stride, cells) != 1) stride += 2;
+    for (k = 0, c = 0; k < cells; k++, c = (c+stride) % cells) {
+	if (replay_check_grid(r, c/n, c%n) == 0) {
+	    *x = c/n; *y = c%n;
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+// Probe cells at Manhattan distance d > 0 from (ci,cj); returns 0 if found,
+// otherwise the smallest check_grid() value seen and its cell in (hi,hj)
+// ((hi,hj) is not set if no probed cell was on the drone path)
+static int probe_diamond(struct replay *r, int ci, int cj, int d,
+	int *hi, int *hj, unsigned int *x, unsigned int *y) {
+    int n = r->traj->grid_size;
+    int best = r->traj->length+1;
+    int k, i, j, s, chk;
+    for (k = 0; k < 4*d; k++) {
+	// Walk the diamond: side s = k/d, position k%d along the side
+	s = k/d;
+	i = ci + ((s == 0) ? d-k%d : (s == 1) ? -(k%d) : (s == 2) ? -d+k%d : k%d);
+	j = cj + ((s == 0) ? k%d : (s == 1) ? d-k%d : (s == 2) ? -(k%d) : -d+k%d);
+	if ((i < 0) || (j < 0) || (i >= n) || (j >= n)) continue;
+	chk = replay_check_grid(r, i, j);
+	if (chk == 0) {
+	    *x = i; *y = j;
+	    return 0;
+	}
+	if (chk < best) {
+	    best = chk; *hi = i; *hj = j;
+	}
+    }
+    return best;
+}
+
+// Scan rows, but after a hit to the drone path with value k search the
+// cells within Manhattan distance k of the hit (the drone moved at most k
+// steps since it was there), re-centering on any closer hit
+int search_path_follow(struct replay *r, unsigned int *x, unsigned int *y) {
+    unsigned int n = r->traj->grid_size;
+    unsigned int i, j;
+    int chk, k, d, ci, cj, best;
+    int hi = -1, hj = -1;		// Closest hit of a diamond; -1 if none
+    for (i = 0; i < n; i++) {
+	for (j = 0; j < n; j++) {
+	    chk = replay_check_grid(r, i, j);
+	    if (chk == 0) {
+		*x = i; *y = j;
+		return 1;
+	    }
+	    if (chk > r->traj->length) continue;
+	    // Hit to drone path: search around it
+	    ci = i; cj = j; k = chk;
+	    for (d = 1; d <= k+1; d++) {
+		hi = hj = -1;
+		best = probe_diamond(r, ci, cj, d, &hi, &hj, x, y);
+		if (best == 0) return 1;
+		if ((best < k) && (hi >= 0)) {
+		    // Closer to the drone; restart around the new hit
+		    ci = hi; cj = hj; k = best; d = 0;
+		}
+	    }
+	}
+    }
+    return 0;
+}
+
+struct search_strategy strategies[] = {
+    {"row_major", search_row_major},
+    {"spiral", search_spiral},
+    {"stride", search_stride},
+    {"path_follow", search_path_follow},
+};
+int num_strategies = sizeof(strategies)/sizeof(strategies[0]);
+
+// -------------------------------------------------------------------------
+// Parse comma-separated list of non-negative integers; returns its length
+int parse_list(const char *s, int *list) {
+    int n = 0;
+    char *end;
+    while ((*s != '\0') && (n < MAX_LIST_LENGTH)) {
+	list[n++] = abs((int) strtol(s, &end, 10));
+	if (*end != ',') break;
+	s = end+1;
+    }
+    return n;
+}
+
+int compare_double(const void *a0, const void *b0) {
+    double a = *(double *)a0;
+    double b = *(double *)b0;
+    return (a < b) ? -1 : (a > b) ? 1 : 0;
+}
+
+// -------------------------------------------------------------------------
+// Main program to benchmark search strategies
+int main(int argc, char *argv[]) {
+    int grid_sizes[MAX_LIST_LENGTH], move_counts[MAX_LIST_LENGTH];
+    int num_grid_sizes, num_move_counts, seed, trials;
+    int g, m, s, t, found;
+    unsigned int x, y;
+    long probes = 0;
+    double times[MAX_TRIALS], time_sec;
+    struct timespec start, stop;
+    struct trajectory traj;
+    struct replay r;
+
+    if (argc != 5) {
+	printf("Need grid sizes, move counts, seed and number of trials as input \n");
+	printf("Use: <executable_name> <grid_size,...> <move_count,...> <random_seed> <trials>\n");
+	exit(0);
+    }
+    num_grid_sizes = parse_list(argv[argc-4], grid_sizes);
+    num_move_counts = parse_list(argv[argc-3], move_counts);
+    seed = atoi(argv[argc-2]);
+    trials = abs(atoi(argv[argc-1]));
+    if (trials < 1) trials = 1;
+    if (trials > MAX_TRIALS) trials = MAX_TRIALS;
+
+    printf("strategy,grid_size,move_count,seed,found,x,y,probes,steps_moved,time_sec,probes_per_sec\n");
+    for (g = 0; g < num_grid_sizes; g++) {
+	// Record trajectory once per grid size
+	trajectory_record(&traj, grid_sizes[g], seed, DRONE_WORLD_PATH_LENGTH);
+	for (m = 0; m < num_move_counts; m++) {
+	    for (s = 0; s < num_strategies; s++) {
+		for (t = 0; t < trials; t++) {
+		    replay_init(&r, &traj, move_counts[m]);
+		    timing_read(&start);
+		    found = strategies[s].search(&r, &x, &y);
+		    timing_read(&stop);
+		    times[t] = timing_elapsed(&start, &stop);
+		    if ((t > 0) && (r.probes != probes)) {
+			printf("Replay of %s is not deterministic (%ld vs %ld probes). Aborting.\n",
+				strategies[s].name, r.probes, probes);
+			exit(0);
+		    }
+		    probes = r.probes;
+		}
+		qsort(times, trials, sizeof(double), compare_double);
+		time_sec = times[trials/2];
+		printf("%s,%u,%d,%d,%d,%u,%u,%ld,%d,", strategies[s].name, traj.grid_size,
+			move_counts[m], seed, found, found ? x : 0, found ? y : 0, probes,
+			r.step-traj.first);
+		// No time to find the drone if the search failed
+		if (found) {
+		    printf("%.6e,%.6e\n", time_sec, (time_sec > 0) ? probes/time_sec : 0.0);
+		} else {
+		    printf(",\n");
+		}
+	    }
+	}
+	trajectory_free(&traj);
+    }
+}
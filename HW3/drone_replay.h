@@ -0,0 +1,117 @@
+// Header file for drone_bench.c
+//
+// Deterministic replay of a drone trajectory for comparing search
+// strategies. A trajectory is recorded once from a drone world (see
+// drone_world.h) with its own random number state, so it depends only on
+// grid size and seed. A replay then plays it back against one search: the
+// drone advances one step along the recorded trajectory after every
+// move_freq+1 hits to its path, as in check_grid() with DRONE_MOVE set.
+// Replays are single-threaded, so a given strategy issues exactly the same
+// probes on every run and the probe count is reproducible across commits.
+//
+// Requires drone_world.h to be included first
+//
+// Contains following routines
+//
+//    trajectory_record(struct trajectory *traj, unsigned int n,
+//                      unsigned int seed, int length)
+//	- record a trajectory of length steps on an n x n grid
+//
+//    trajectory_free(struct trajectory *traj)
+//
+//    replay_init(struct replay *r, struct trajectory *traj, int move_freq)
+//	- start a replay of traj at its initial location
+//
+//    replay_check_grid(struct replay *r, unsigned int x, unsigned int y)
+//	- check_grid() against the replayed drone
+//
+// Search strategies take a replay, probe it with replay_check_grid() and
+// return 1 with the location in (*x, *y) once a probe returns 0
+//
+#ifndef DRONE_REPLAY_H
+#define DRONE_REPLAY_H
+
+#include <stdlib.h>
+
+struct trajectory {
+    unsigned int grid_size;
+    int length;				// number of recorded steps
+    int first;				// step at which replays start
+    unsigned int *x;			// x[s] = x-coordinate at step s
+    unsigned int *y;			// y[s] = y-coordinate at step s
+};
+
+struct replay {
+    struct trajectory *traj;
+    int move_freq;			// hits to the path between moves
+    int step;				// current step of the drone
+    int move_counter;			// hits since last move
+    long probes;			// probes issued so far
+};
+
+struct search_strategy {
+    const char *name;
+    int (*search)(struct replay *r, unsigned int *x, unsigned int *y);
+};
+
+// -------------------------------------------------------------------------
+// Trajectories and replays
+
+// Record trajectory of length steps on an n x n grid; the drone is placed
+// and moved 16 times as in initialize_grid() before replays start
+void trajectory_record(struct trajectory *traj, unsigned int n, unsigned int seed, int length) {
+    struct drone_world w;
+    int s;
+    if (length < 17) length = 17;
+    world_init(&w, n, 1, seed, 0, 0, length);
+    for (s = 17; s < length; s++)
+	world_move_drone(&w, 0);
+    traj->grid_size = w.grid_size;
+    traj->length = length;
+    traj->first = 16;
+    traj->x = (unsigned int *) malloc(length*sizeof(unsigned int));
+    traj->y = (unsigned int *) malloc(length*sizeof(unsigned int));
+    for (s = 0; s < length; s++) {
+	traj->x[s] = w.drones[0].x[s];
+	traj->y[s] = w.drones[0].y[s];
+    }
+    world_free(&w);
+}
+
+void trajectory_free(struct trajectory *traj) {
+    free(traj->x);
+    free(traj->y);
+}
+
+// Start replay of traj; the drone moves after every move_freq+1 path hits
+void replay_init(struct replay *r, struct trajectory *traj, int move_freq) {
+    r->traj = traj;
+    r->move_freq = move_freq;
+    r->step = traj->first;
+    r->move_counter = 0;
+    r->probes = 0;
+}
+
+// Check grid location (x,y) against the replayed drone; same return values
+// as world_check_grid(), and a hit to the path may move the drone one step
+int replay_check_grid(struct replay *r, unsigned int x, unsigned int y) {
+    int i = r->step;
+    int steps;
+    r->probes++;
+    while ((i >= 0) && ((x != r->traj->x[i]) || (y != r->traj->y[i]))) {
+	i--;
+    }
+    if (i < 0)
+	// (x,y) not in drone path
+	return r->traj->length+1;
+    steps = r->step - i;
+    if (r->move_counter < r->move_freq) {
+	r->move_counter++;
+    } else if (r->step < r->traj->length-1) {
+	r->move_counter = 0;
+	r->step++;
+    }
+    return steps;
+}
+
+#endif
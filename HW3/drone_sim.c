@@ -0,0 +1,252 @@
+// Game of Drones - many scenarios in one process
+//
+// Reads search scenarios (grid size, number of drones, seed, delay, move
+// count) from a scenario file, builds one drone world per scenario (see
+// drone_world.h) and finds all drones of every scenario with one shared
+// pool of worker threads. Each scenario is split into tasks of a few grid
+// rows; workers take tasks from a shared queue in scenario order, so the
+// pool moves on to the next scenario as soon as threads free up.
+//
+// Scenario file format: one scenario per line, blank lines and lines
+// starting with # are ignored
+//
+//   <name> <grid_size> <num_drones> <random_seed> <delay_nanosecs> <move_count>
+//
+// Warning: Return values of calls are not checked for error to keep
+// the code simple.
+//
+// Requires drone_world.h to be in the same directory
+//
+// Compilation command on ADA:
+//
+//   module load intel/2017A
+//   icc -o drone_sim.exe drone_sim.c -lpthread -lrt
+//
+// Sample execution and output ($ sign is the shell prompt):
+//
+// $ ./drone_sim.exe drone_scenarios.txt 20
+//   Scenario = g10_s44_d0_m10000, grid = 10, drones = 1, found = 1, success = 1, probes = 80, time (sec) = 0.000006486
+//   ...
+//   Scenarios = 28, threads = 20, total time (sec) = 6.931317885
+//
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "drone_world.h"
+#include "../common/timing.h"
+
+#define MAX_THREADS     1024
+#define MAX_SCENARIOS   4096
+#define MAX_NAME_LENGTH 64
+#define TASKS_PER_THREAD 4		// Tasks per scenario per worker thread
+
+struct scenario {
+    char name[MAX_NAME_LENGTH];
+    unsigned int grid_size;
+    int num_drones, seed, delay_nsecs, move_count;
+
+    struct drone_world world;
+    unsigned int rows_per_task;
+    int num_tasks;
+    int tasks_done;			// Tasks completed or skipped
+    int num_found;			// Drones found so far
+    unsigned int *found_x, *found_y;	// Location where each drone was found
+    char *found;			// found[d] = 1 once drone d is found
+    long probes;			// Number of probes issued
+    struct timespec start, stop;
+    int started;
+    pthread_mutex_t lock;		// Protects the fields above
+};
+
+struct task {
+    int scenario;
+    unsigned int first_row, last_row;	// rows [first_row ... last_row-1]
+};
+
+struct scenario scenarios[MAX_SCENARIOS];
+int num_scenarios;
+
+struct task *tasks;			// Shared task queue
+int num_tasks;
+int next_task = 0;			// Next task to take; taken atomically
+
+int num_threads;
+pthread_t p_threads[MAX_THREADS];
+
+// -------------------------------------------------------------------------
+// Read scenarios from file; returns number of scenarios read
+int read_scenarios(const char *file_name) {
+    char line[512];
+    int n = 0;
+    struct scenario *s;
+    FILE *fp = fopen(file_name, "r");
+    if (fp == NULL) {
+	printf("Cannot open scenario file %s. Aborting.\n", file_name);
+	exit(0);
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+	char *p = line + strspn(line, " \t");
+	if ((*p == '#') || (*p == '\n') || (*p == '\0')) continue;
+	if (n == MAX_SCENARIOS) {
+	    printf("Maximum number of scenarios allowed: %d. Ignoring the rest.\n", MAX_SCENARIOS);
+	    break;
+	}
+	s = &scenarios[n];
+	if (sscanf(p, "%63s %u %d %d %d %d", s->name, &s->grid_size, &s->num_drones,
+		    &s->seed, &s->delay_nsecs, &s->move_count) != 6) {
+	    printf("Invalid scenario (need name and five integers): %s", p);
+	    exit(0);
+	}
+	s->delay_nsecs = abs(s->delay_nsecs);
+	s->move_count = abs(s->move_count);
+	n++;
+    }
+    fclose(fp);
+    return n;
+}
+
+// Worker thread: take tasks from the shared queue until it is empty
+void *worker(void *arg) {
+    int k, d, n, num_ids, chk;
+    int *drone_ids;			// Drones reported by a probe
+    unsigned int i, j;
+    struct task *tk;
+    struct scenario *s;
+    (void) arg;
+    while ((k = __atomic_fetch_add(&next_task, 1, __ATOMIC_RELAXED)) < num_tasks) {
+	tk = &tasks[k];
+	s = &scenarios[tk->scenario];
+	drone_ids = (int *) malloc(s->num_drones*sizeof(int));
+
+	pthread_mutex_lock(&s->lock);
+	if (!s->started) {
+	    timing_read(&s->start);
+	    s->started = 1;
+	}
+	pthread_mutex_unlock(&s->lock);
+
+	for (i = tk->first_row; i < tk->last_row; i++) {
+	    // Stop early once all drones of this scenario are found
+	    if (__atomic_load_n(&s->num_found, __ATOMIC_RELAXED) == s->num_drones) break;
+	    for (j = 0; j < s->grid_size; j++) {
+		chk = world_check_grid(&s->world, i, j, drone_ids, &num_ids);
+		__atomic_fetch_add(&s->probes, 1, __ATOMIC_RELAXED);
+		if (chk == 0) {
+		    // Every drone in the cell is found
+		    pthread_mutex_lock(&s->lock);
+		    for (n = 0; n < num_ids; n++) {
+			d = drone_ids[n];
+			if (!s->found[d]) {
+			    s->found[d] = 1;
+			    s->found_x[d] = i;
+			    s->found_y[d] = j;
+			    __atomic_store_n(&s->num_found, s->num_found+1, __ATOMIC_RELAXED);
+			}
+		    }
+		    pthread_mutex_unlock(&s->lock);
+		}
+	    }
+	}
+
+	pthread_mutex_lock(&s->lock);
+	if (++s->tasks_done == s->num_tasks) timing_read(&s->stop);
+	pthread_mutex_unlock(&s->lock);
+	free(drone_ids);
+    }
+    return NULL;
+}
+
+// -------------------------------------------------------------------------
+// Main program to find the drones of all scenarios
+int main(int argc, char *argv[]) {
+    struct timespec start, stop;
+    double total_time;
+    struct scenario *s;
+    unsigned int row;
+    int i, d, n, num_ids, success;
+    int *drone_ids;
+
+    if (argc != 3) {
+	printf("Need scenario file and number of threads as input \n");
+	printf("Use: <executable_name> <scenario_file> <num_threads>\n");
+	exit(0);
+    }
+    num_scenarios = read_scenarios(argv[argc-2]);
+    if ((num_threads = abs(atoi(argv[argc-1]))) > MAX_THREADS) {
+	printf("Maximum number of threads allowed: %d.\n", MAX_THREADS);
+	exit(0);
+    }
+    if (num_threads < 1) num_threads = 1;
+
+    // Build worlds and split each scenario into tasks of a few rows
+    num_tasks = 0;
+    for (i = 0; i < num_scenarios; i++) {
+	s = &scenarios[i];
+	world_init(&s->world, s->grid_size, s->num_drones, s->seed, s->delay_nsecs,
+		s->move_count, DRONE_WORLD_PATH_LENGTH);
+	s->grid_size = s->world.grid_size;
+	s->num_drones = s->world.num_drones;
+	s->rows_per_task = s->grid_size/(TASKS_PER_THREAD*num_threads);
+	if (s->rows_per_task < 1) s->rows_per_task = 1;
+	s->num_tasks = (s->grid_size+s->rows_per_task-1)/s->rows_per_task;
+	s->found = (char *) calloc(s->num_drones, sizeof(char));
+	s->found_x = (unsigned int *) calloc(s->num_drones, sizeof(unsigned int));
+	s->found_y = (unsigned int *) calloc(s->num_drones, sizeof(unsigned int));
+	pthread_mutex_init(&s->lock, NULL);
+	num_tasks += s->num_tasks;
+    }
+    tasks = (struct task *) malloc(num_tasks*sizeof(struct task));
+    num_tasks = 0;
+    for (i = 0; i < num_scenarios; i++) {
+	s = &scenarios[i];
+	for (row = 0; row < s->grid_size; row += s->rows_per_task) {
+	    tasks[num_tasks].scenario = i;
+	    tasks[num_tasks].first_row = row;
+	    tasks[num_tasks].last_row = (row+s->rows_per_task < s->grid_size) ?
+		row+s->rows_per_task : s->grid_size;
+	    num_tasks++;
+	}
+    }
+
+    // Run all scenarios on one pool of worker threads
+    timing_read(&start);
+    for (i = 0; i < num_threads; i++) {
+	pthread_create(&p_threads[i], NULL, worker, NULL);
+    }
+    for (i = 0; i < num_threads; i++) {
+	pthread_join(p_threads[i], NULL);
+    }
+    timing_read(&stop);
+    total_time = timing_elapsed(&start, &stop);
+
+    // Check if drones found, print time taken per scenario
+    for (i = 0; i < num_scenarios; i++) {
+	s = &scenarios[i];
+	success = 0;
+	drone_ids = (int *) malloc(s->num_drones*sizeof(int));
+	for (d = 0; d < s->num_drones; d++) {
+	    if (!s->found[d]) continue;
+	    // Drone d must still be at the cell where it was found
+	    num_ids = world_drones_at(&s->world, s->found_x[d], s->found_y[d], drone_ids);
+	    for (n = 0; n < num_ids; n++) {
+		if (drone_ids[n] == d) {
+		    success++;
+		    break;
+		}
+	    }
+	}
+	free(drone_ids);
+	printf("Scenario = %s, grid = %u, drones = %d, found = %d, success = %d, probes = %ld, time (sec) = %.9f\n",
+		s->name, s->grid_size, s->num_drones, s->num_found, success, s->probes,
+		timing_elapsed(&s->start, &s->stop));
+	world_free(&s->world);
+	free(s->found); free(s->found_x); free(s->found_y);
+	pthread_mutex_destroy(&s->lock);
+    }
+    printf("Scenarios = %d, threads = %d, total time (sec) = %.9f\n",
+	    num_scenarios, num_threads, total_time);
+    free(tasks);
+}
@@ -0,0 +1,227 @@
+// Header file for drone_sim.c
+//
+// Contains data structure for a drone world: one grid with one or more
+// drones, each with its own path, plus the delay and move frequency of
+// the world and its own random number state. Unlike drone.h, which keeps a
+// single drone in global variables, any number of worlds can exist in one
+// process and be probed concurrently.
+//
+// Concurrency follows drone.h: drone paths are append-only, a new step is
+// published by advancing current with a release store, readers take one
+// acquire load as their snapshot, and moves are serialized by the world's
+// lock. Compile with -DDRONE_MOVE=1 to let probes move the drone they hit.
+//
+// Contains following routines
+//
+//    world_init(struct drone_world *w, unsigned int n, int num_drones,
+//               unsigned int seed, int delay_nsecs, int move_count,
+//               unsigned int max_path_length)
+//	- initialize an n x n grid with num_drones drones placed randomly,
+//	  followed by calls to world_move_drone(); delay_nsecs is the delay
+//	  of each world_check_grid() call in nanoseconds
+//
+//    world_free(struct drone_world *w)
+//	- release the drone paths of a world
+//
+//    world_move_drone(struct drone_world *w, int d)
+//	- move drone d to one of the four neighboring cells chosen randomly
+//	  or remain in its current location
+//
+//    world_check_grid(struct drone_world *w, unsigned int x, unsigned int y,
+//                     int *drone_ids, int *num_ids)
+//	- check grid location (x,y) after the world's delay; returns the
+//	  smallest check_grid() value over all drones, and all drones it
+//	  belongs to (e.g. every drone at (x,y)) in drone_ids[0 ... *num_ids-1]
+//
+//    world_drones_at(struct drone_world *w, unsigned int x, unsigned int y,
+//                    int *drone_ids)
+//	- returns the number of drones currently at (x,y) and stores them
+//	  in drone_ids
+//
+#ifndef DRONE_WORLD_H
+#define DRONE_WORLD_H
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef DRONE_MOVE
+#define DRONE_MOVE 0			// Use DRONE_MOVE to let probes move
+					// the drone
+#endif
+
+#define DRONE_WORLD_PATH_LENGTH 65536	// Default no. of steps a drone can
+					// take in a world
+
+// -------------------------------------------------------------------------
+// Data structures for drone worlds
+
+struct drone_track {
+    unsigned int *x;			// x-coordinate of cell on drone path
+    unsigned int *y;			// y-coordinate of cell on drone path
+    unsigned int *t;			// step number when drone was at cell
+    unsigned int current;		// current step number; published
+					// with release/acquire
+    unsigned int move_counter;		// count number of hits to drone path
+					// since last drone move
+};
+
+struct drone_world {
+    unsigned int grid_size;		// grid is grid_size x grid_size
+    int num_drones;
+    struct drone_track *drones;
+    unsigned int max_path_length;	// maximum no. of steps of each drone
+    struct timespec delay;		// forced delay at each check
+    unsigned int move_freq;		// number of hits to a drone path
+					// before that drone can move one step
+    unsigned short rand_state[3];	// nrand48() state of this world
+    pthread_mutex_t lock;		// Serializes writers of drone paths
+					// and rand_state
+};
+
+// -------------------------------------------------------------------------
+// Routines for drone worlds
+
+// Move drone d of world w to one of the four neighboring cells chosen
+// randomly or remain in its current location
+// - A drone that has reached max_path_length steps stays where it is
+//
+void world_move_drone(struct drone_world *w, int d) {
+    struct drone_track *drone = &w->drones[d];
+    unsigned int next;
+    pthread_mutex_lock(&w->lock);
+    if (drone->move_counter < w->move_freq) {
+	// Do not move if number of hits to drone path below move_freq
+	drone->move_counter++;
+    } else if (drone->current < w->max_path_length-1) {
+	// Move drone randomly to one of four neighbor cells
+	drone->move_counter = 0;
+	next = drone->current+1;
+	drone->x[next] = drone->x[next-1];
+	drone->y[next] = drone->y[next-1];
+	drone->t[next] = drone->t[next-1]+1;
+	switch (nrand48(w->rand_state) % 4) {
+	    case 0: // Move right (left if reached grid edge)
+		if (drone->x[next-1] < w->grid_size-1) drone->x[next]++;
+		else drone->x[next]--;
+		break;
+	    case 1: // Move left (right if reached grid edge)
+		if (drone->x[next-1] > 0) drone->x[next]--;
+		else drone->x[next]++;
+		break;
+	    case 2: // Move up (down if reached grid edge)
+		if (drone->y[next-1] < w->grid_size-1) drone->y[next]++;
+		else drone->y[next]--;
+		break;
+	    case 3: // Move down (up if reached grid edge)
+		if (drone->y[next-1] > 0) drone->y[next]--;
+		else drone->y[next]++;
+		break;
+	}
+	// Publish new step
+	__atomic_store_n(&drone->current, next, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&w->lock);
+}
+
+// Initialize world w: grid size, drone locations, and delay for each check
+void world_init(struct drone_world *w, unsigned int n, int num_drones,
+	unsigned int seed, int delay_nsecs, int move_count,
+	unsigned int max_path_length) {
+    int d, i;
+    w->grid_size = (n > 1) ? n : 2;
+    w->num_drones = (num_drones > 0) ? num_drones : 1;
+    w->max_path_length = (max_path_length > 16) ? max_path_length : DRONE_WORLD_PATH_LENGTH;
+    w->rand_state[0] = 0x330E;		// Same initial state as srand48(seed)
+    w->rand_state[1] = (unsigned short) seed;
+    w->rand_state[2] = (unsigned short) (seed >> 16);
+    pthread_mutex_init(&w->lock, NULL);
+    w->drones = (struct drone_track *) calloc(w->num_drones, sizeof(struct drone_track));
+    // Place drones at random grid locations, then move each 16 times
+    w->move_freq = 0;
+    for (d = 0; d < w->num_drones; d++) {
+	w->drones[d].x = (unsigned int *) malloc(w->max_path_length*sizeof(unsigned int));
+	w->drones[d].y = (unsigned int *) malloc(w->max_path_length*sizeof(unsigned int));
+	w->drones[d].t = (unsigned int *) malloc(w->max_path_length*sizeof(unsigned int));
+	w->drones[d].current = 0;
+	w->drones[d].move_counter = 0;
+	w->drones[d].x[0] = nrand48(w->rand_state) % w->grid_size;
+	w->drones[d].y[0] = nrand48(w->rand_state) % w->grid_size;
+	w->drones[d].t[0] = 0;
+	for (i = 0; i < 16; i++)
+	    world_move_drone(w, d);
+    }
+    // Initialize move counter and delay
+    w->move_freq = (unsigned int) move_count;
+    w->delay.tv_sec = delay_nsecs/1000000000;
+    w->delay.tv_nsec = delay_nsecs%1000000000;
+}
+
+// Release drone paths of world w
+void world_free(struct drone_world *w) {
+    int d;
+    for (d = 0; d < w->num_drones; d++) {
+	free(w->drones[d].x);
+	free(w->drones[d].y);
+	free(w->drones[d].t);
+    }
+    free(w->drones);
+    pthread_mutex_destroy(&w->lock);
+}
+
+// Check grid location (x,y) of world w
+// - Returns 0 if a drone is at (x,y)
+// - Returns w->max_path_length+1 if no drone was ever at (x,y)
+// - Otherwise returns the smallest number of steps any drone has taken
+//   since it was last at (x,y)
+// - drone_ids[0 ... *num_ids-1] are set to all drones the return value
+//   belongs to (*num_ids = 0 if none), so drones that share a cell are all
+//   reported; drone_ids must have room for w->num_drones drones. These
+//   drones may move if DRONE_MOVE is set
+//
+int world_check_grid(struct drone_world *w, unsigned int x, unsigned int y, int *drone_ids,
+	int *num_ids) {
+    int d, i, current, steps;
+    int best = w->max_path_length+1;
+    int count = 0;
+    struct drone_track *drone;
+
+    if (w->delay.tv_sec || w->delay.tv_nsec) nanosleep(&w->delay, NULL);
+    for (d = 0; d < w->num_drones; d++) {
+	drone = &w->drones[d];
+	current = __atomic_load_n(&drone->current, __ATOMIC_ACQUIRE);
+	i = current;
+	while ((i >= 0) && ((x != drone->x[i]) || (y != drone->y[i]))) {
+	    i--;
+	}
+	if (i >= 0) {
+	    steps = drone->t[current] - drone->t[i];
+	    if (steps < best) {
+		best = steps;
+		count = 0;
+	    }
+	    if (steps == best) drone_ids[count++] = d;
+	}
+    }
+    if (DRONE_MOVE) {
+	for (i = 0; i < count; i++)
+	    world_move_drone(w, drone_ids[i]);
+    }
+    *num_ids = count;
+    return best;
+}
+
+// Returns the number of drones currently at (x,y); the drones are stored
+// in drone_ids, which must have room for w->num_drones drones
+int world_drones_at(struct drone_world *w, unsigned int x, unsigned int y, int *drone_ids) {
+    int d, current, count = 0;
+    for (d = 0; d < w->num_drones; d++) {
+	current = __atomic_load_n(&w->drones[d].current, __ATOMIC_ACQUIRE);
+	if ((x == w->drones[d].x[current]) && (y == w->drones[d].y[current]))
+	    drone_ids[count++] = d;
+    }
+    return count;
+}
+
+#endif
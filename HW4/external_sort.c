@@ -0,0 +1,531 @@
+// -----------------------------------------------------------------------------
+// External (out-of-core) Sample Sort to sort a list of integers distributed
+// across processors, for lists larger than the memory of the processes
+// MPI-based implementation; works with any number of processes
+//
+// The local list is processed run_size elements (one run) at a time:
+//   1. Runs     - each process generates its list run_size elements at a
+//		   time, sorts each run and writes it to a file in tmp_dir;
+//		   regular samples of every run are kept
+//   2. Splitters - samples of all processes are gathered; p-1 of them are
+//		   chosen as splitters, as in sample_sort.c
+//   3. Exchange - run r of every process is read back, split at the
+//		   splitters and redistributed with one MPI_Alltoallv; each
+//		   process merges the p pieces it receives into a new run file
+//   4. Merge    - each process streams k-way merges of its received runs
+//		   into its output file, tmp_dir/sorted_<rank>.bin; the
+//		   merge buffers share the memory of one run (run_size
+//		   elements), so at most run_size/IO_BLOCK_SIZE-1 runs are
+//		   merged at a time, and more runs are merged in passes
+//		   through intermediate files
+// Memory: phases 1 and 4 hold 2*run_size elements (run and sort scratch)
+// and run_size elements (merge buffers). In phase 3, a process receives
+// the elements of run r of all processes that fall in its range: about
+// run_size with balanced splitters, but up to num_procs*run_size when keys
+// are skewed. The receive buffer and the output of the in-memory merge
+// grow to that size, so the worst case is 2*num_procs*run_size elements;
+// with VERBOSE > 0, the largest received run is reported.
+// All file I/O is sequential, in blocks of IO_BLOCK_SIZE elements or more
+// when a run holds at least 3*IO_BLOCK_SIZE elements. The output files
+// are checked by streaming them once more; their checksum (list_checksum.h)
+// must equal the checksum of the generated lists.
+//
+// Compilation command on ADA:
+//
+//   module load intel/2017A
+//   mpiicc -o external_sort.exe external_sort.c -lpthread
+//
+// Routines:
+//   generate_run	- generate part of the local list
+//   run_reader_*	- buffered sequential reading of a run file
+//   merge_run_files	- streamed k-way merge of run files
+//   merge_in_passes	- merge any number of run files in bounded memory
+//   check_output	- check that output files are sorted and complete
+//   main		- main program that implements external sample sort
+//
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "mpi.h"
+#include "sample_sort.h"
+#include "list_checksum.h"
+#include "../common/timing.h"
+
+#define MAX_RUN_SIZE		268435456
+#define MAX_PATH_LENGTH		1024
+#ifndef IO_BLOCK_SIZE
+#define IO_BLOCK_SIZE		(1 << 20)	// Minimum elements per read/write
+#endif
+
+#ifndef KEEP_OUTPUT
+#define KEEP_OUTPUT 0			// Keep output files if nonzero
+#endif
+
+#ifndef VERBOSE
+#define VERBOSE 0			// Use VERBOSE to control output
+#endif
+
+// Local sort routines for int, generated from local_sort.h:
+// 	local_sort_int(list, scratch, list_size, num_threads)
+// sorts list[0 ... list_size-1] in ascending order
+//
+#define SORT_NAME		int
+#define SORT_KEY		int
+#define SORT_ORDER_KEY(e)	((uint64_t) ((uint32_t) (e) ^ 0x80000000u))
+#define SORT_KEY_BYTES		4
+#include "local_sort.h"
+
+// Routines --------------------------------------------------------------------
+//
+// Generate elements first ... first+n-1 of the local list; same element
+// types as initialize_list in qsort_hypercube.h (for random lists, calls
+// must be made in order after srand48(type + my_id))
+// Input:
+//   first, n	- first element and number of elements to generate
+//   list_size	- size of the whole local list
+//   type, my_id, num_procs	- as in initialize_list
+// Output:
+//   list	- n elements
+//
+void generate_run(int *list, long long first, int n, long long list_size, int type,
+	int my_id, int num_procs) {
+    int j;
+    for (j = 0; j < n; j++) {
+	switch (type) {
+	    case -1:	// Elements are in descending order
+		list[j] = (int) ((num_procs-my_id)*list_size-(first+j));
+		break;
+	    case -2:	// Elements are in ascending order
+		list[j] = (int) (my_id*list_size+(first+j)+1);
+		break;
+	    default:
+		list[j] = lrand48() % 100;
+		break;
+	}
+    }
+}
+
+// Buffered reader of a run file
+struct run_reader {
+    FILE * fp;
+    int * buffer;
+    int buffer_size;		// Elements buffer can hold
+    int size;			// Elements in buffer
+    int pos;			// Next element of buffer
+};
+
+// Open run file path for reading with a buffer of buffer_size elements;
+// returns 0 if the run is empty
+int run_reader_open(struct run_reader *r, const char *path, int buffer_size) {
+    r->fp = fopen(path, "rb");
+    if (r->fp == NULL) {
+	printf("Cannot open run file %s. Aborting ...\n", path);
+	MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    r->buffer = (int *) malloc(buffer_size*sizeof(int));
+    r->buffer_size = buffer_size;
+    r->size = (int) fread(r->buffer, sizeof(int), buffer_size, r->fp);
+    r->pos = 0;
+    return (r->size > 0);
+}
+
+// Advance to next element; returns 0 at the end of the run
+int run_reader_next(struct run_reader *r) {
+    if (++r->pos < r->size) return 1;
+    r->size = (int) fread(r->buffer, sizeof(int), r->buffer_size, r->fp);
+    r->pos = 0;
+    return (r->size > 0);
+}
+
+void run_reader_close(struct run_reader *r) {
+    fclose(r->fp);
+    free(r->buffer);
+}
+
+// Write n elements to file in one call
+void write_block(FILE *fp, int *list, long long n) {
+    if ((long long) fwrite(list, sizeof(int), n, fp) != n) {
+	printf("Cannot write run file. Aborting ...\n");
+	MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+}
+
+// Merge sorted run files into one sorted output file with a heap of run
+// heads; each run is read, and the output written, in blocks of
+// buffer_size elements
+// Input:
+//   paths, num_runs	- run files and their number
+//   buffer_size	- elements per read/write buffer
+//   out_path		- output file
+// Output:
+//   number of elements written
+//
+long long merge_run_files(char (*paths)[MAX_PATH_LENGTH], int num_runs, int buffer_size,
+	const char *out_path) {
+    struct run_reader * runs = (struct run_reader *) malloc(num_runs*sizeof(struct run_reader));
+    int * heap = (int *) malloc(num_runs*sizeof(int));	// run indices
+    int * out = (int *) malloc(buffer_size*sizeof(int));
+    int heap_size = 0, out_size = 0;
+    long long total = 0;
+    int r, i, child;
+    FILE * fp = fopen(out_path, "wb");
+    if (fp == NULL) {
+	printf("Cannot open output file %s. Aborting ...\n", out_path);
+	MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+#define HEAD(r)	(runs[r].buffer[runs[r].pos])
+    for (r = 0; r < num_runs; r++) {
+	if (run_reader_open(&runs[r], paths[r], buffer_size)) heap[heap_size++] = r;
+    }
+    // Build heap on run heads
+    for (i = heap_size/2-1; i >= 0; i--) {
+	r = heap[i];
+	while ((child = 2*i+1) < heap_size) {
+	    if ((child+1 < heap_size) && (HEAD(heap[child+1]) < HEAD(heap[child]))) child++;
+	    if (HEAD(r) <= HEAD(heap[child])) break;
+	    heap[i] = heap[child]; i = child;
+	}
+	heap[i] = r;
+    }
+    // Repeatedly take smallest head, advance its run, restore heap
+    while (heap_size > 0) {
+	r = heap[0];
+	out[out_size++] = HEAD(r);
+	if (out_size == buffer_size) {
+	    write_block(fp, out, out_size);
+	    total += out_size; out_size = 0;
+	}
+	if (!run_reader_next(&runs[r])) r = heap[--heap_size];
+	i = 0;
+	while ((child = 2*i+1) < heap_size) {
+	    if ((child+1 < heap_size) && (HEAD(heap[child+1]) < HEAD(heap[child]))) child++;
+	    if (HEAD(r) <= HEAD(heap[child])) break;
+	    heap[i] = heap[child]; i = child;
+	}
+	if (heap_size > 0) heap[i] = r;
+    }
+#undef HEAD
+    write_block(fp, out, out_size);
+    total += out_size;
+
+    fclose(fp);
+    for (r = 0; r < num_runs; r++) run_reader_close(&runs[r]);
+    free(runs); free(heap); free(out);
+    return total;
+}
+
+// Merge sorted run files into one sorted output file with read/write
+// buffers of at most memory elements in all: at most max_fan_in =
+// memory/IO_BLOCK_SIZE-1 runs (at least 2) are merged at a time, each
+// through a buffer of memory/(k+1) elements for k runs. With more runs,
+// groups of max_fan_in runs are merged into intermediate files
+// tmp_dir/merge_<rank>_<pass>_<group>.bin, pass after pass, until one
+// merge into the output file is left. Input and intermediate files are
+// removed once merged
+// Input:
+//   paths, num_runs	- run files and their number
+//   memory		- elements of all merge buffers
+//   tmp_dir, my_id	- directory and rank for intermediate files
+//   out_path		- output file
+// Output:
+//   number of elements written
+//
+long long merge_in_passes(char (*paths)[MAX_PATH_LENGTH], int num_runs, int memory,
+	const char *tmp_dir, int my_id, const char *out_path) {
+    char (*next_paths)[MAX_PATH_LENGTH];
+    int max_fan_in = memory/IO_BLOCK_SIZE-1;
+    int pass, num_groups, g, k, r, buffer_size;
+    long long total = 0;
+    if (max_fan_in < 2) max_fan_in = 2;
+    for (pass = 0; ; pass++) {
+	num_groups = (num_runs+max_fan_in-1)/max_fan_in;
+	next_paths = (char (*)[MAX_PATH_LENGTH]) malloc(num_groups*MAX_PATH_LENGTH);
+	for (g = 0; g < num_groups; g++) {
+	    k = (num_runs-g*max_fan_in < max_fan_in) ? num_runs-g*max_fan_in : max_fan_in;
+	    if (num_groups == 1) {
+		snprintf(next_paths[g], MAX_PATH_LENGTH, "%s", out_path);
+	    } else {
+		snprintf(next_paths[g], MAX_PATH_LENGTH, "%s/merge_%d_%d_%d.bin", tmp_dir, my_id, pass, g);
+	    }
+	    buffer_size = (memory/(k+1) > 0) ? memory/(k+1) : 1;
+	    total = merge_run_files(&paths[g*max_fan_in], k, buffer_size, next_paths[g]);
+	    for (r = g*max_fan_in; r < g*max_fan_in+k; r++) remove(paths[r]);
+	}
+	if (pass > 0) free(paths);
+	if (VERBOSE > 1) {
+	    printf("[Proc: %0d] merge pass %d: %d runs into %d\n", my_id, pass, num_runs, num_groups);
+	}
+	paths = next_paths;
+	num_runs = num_groups;
+	if (num_groups == 1) break;
+    }
+    free(paths);
+    return total;
+}
+
+// Check that the output file of every process is sorted, that its
+// elements are larger than or equal to the largest element of the output
+// of process (my_id-1), that no elements were lost, and that the output
+// files are a permutation of the generated lists (equal checksums); the
+// files are streamed in blocks of buffer_size elements
+// Input:
+//   path		- output file of this process
+//   buffer_size	- elements per read
+//   expected_total	- number of elements of all processes
+//   checksum		- checksum of the generated lists of all processes
+//   my_id, num_procs	- rank and number of MPI processes
+//
+void check_output(const char *path, int buffer_size, long long expected_total,
+	struct list_checksum *checksum, int my_id, int num_procs) {
+    struct run_reader r;
+    struct list_checksum local_checksum = {0, 0, 0}, output_checksum;
+    int max_nbr = -1, last, local_error = 0, error;
+    long long count = 0, total;
+    if (my_id-1 >= 0) {
+	MPI_Recv(&max_nbr, 1, MPI_INT, my_id-1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+    last = max_nbr;
+    if (run_reader_open(&r, path, buffer_size)) {
+	do {
+	    if (r.pos == 0) add_list_checksum(r.buffer, r.size, &local_checksum);
+	    if (r.buffer[r.pos] < last) local_error = 1;
+	    last = r.buffer[r.pos];
+	    count++;
+	} while (run_reader_next(&r));
+    }
+    run_reader_close(&r);
+    if (my_id+1 < num_procs) {
+	MPI_Send(&last, 1, MPI_INT, my_id+1, 0, MPI_COMM_WORLD);
+    }
+    MPI_Reduce(&local_error, &error, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&count, &total, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    global_list_checksum(&local_checksum, &output_checksum, MPI_COMM_WORLD);
+    if (VERBOSE > 1) {
+	printf("[Proc: %0d] check_output: local_error = %d, elements = %lld\n", my_id, local_error, count);
+    }
+    if (my_id == 0) {
+	if ((error != 0) || (total != expected_total)) {
+	    printf("[Proc: %0d] Error encountered. The list has not been sorted correctly.\n", my_id);
+	}
+	if (!list_checksum_equal(checksum, &output_checksum)) {
+	    printf("[Proc: %0d] Error encountered. The list is not a permutation of the initial list.\n", my_id);
+	}
+    }
+}
+
+//------------------------------------------------------------------------------
+// Main program
+//
+int main(int argc, char *argv[])
+{
+    // Local Variables ++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+    long long list_size;	// Local list size (need not fit in memory)
+    int run_size;		// Elements per run (in memory at a time)
+    int num_runs;		// Number of runs per process
+    int type;			// Method for initializing local lists
+    int num_threads;		// Number of threads used for local sort
+    const char * tmp_dir;	// Directory for run and output files
+    int * list;			// Current run
+    int list_capacity;		// Number of elements list can hold
+    int * work;			// Local sort scratch, then received pieces
+    int n;			// Size of current run
+    int merge_memory;		// Elements of all read/write buffers in merge
+    int max_received = 0;	// Elements of the largest received run
+    char (*run_paths)[MAX_PATH_LENGTH];		// Sorted local runs
+    char (*part_paths)[MAX_PATH_LENGTH];	// Merged received pieces
+    char out_path[MAX_PATH_LENGTH];		// Output file
+    FILE * fp;
+    long long merged;		// Elements in output file
+    struct list_checksum local_checksum = {0, 0, 0};	// Of generated local list
+    struct list_checksum checksum;	// Of generated lists of all processes
+
+    int * my_samples;		// Regular samples of all local runs
+    int * samples;		// Regular samples of all processes
+    int num_samples;		// Samples per process
+    int * splitters;		// num_procs-1 splitters
+    int * split;		// Piece j of run starts at split[j]
+    int * send_counts, * send_displs;	// Pieces sent to each process
+    int * recv_counts, * recv_displs;	// Pieces received from each process
+    int work_capacity;
+    int j, r;
+
+    // MPI variables
+    int num_procs; 		// Number of MPI processes
+    int my_id;			// Rank/id of this process
+    int provided;		// Thread support level provided by MPI
+
+    // Timing variables
+    double t_runs, t_exchange, t_merge, total_time;
+
+    // External Sample Sort Algorithm ++++++++++++++++++++++++++++++++++++++++++
+
+    MPI_Init_thread(&argc,&argv,MPI_THREAD_FUNNELED,&provided);	// Initialize MPI
+    MPI_Comm_size(MPI_COMM_WORLD,&num_procs);	// num_procs = number of MPI processes
+    MPI_Comm_rank(MPI_COMM_WORLD,&my_id);	// my_id = rank of this process
+
+    //  Check inputs
+    if ((argc != 5) && (argc != 6))  {
+	if (my_id == 0)
+	    printf("Usage: mpirun -np <number_of_processes> <executable_name> <list_size_per_process> <type> <run_size> <tmp_dir> [<threads_per_process>]\n");
+	exit(0);
+    }
+    list_size = atoll(argv[1]);
+    type = atoi(argv[2]);
+    run_size = atoi(argv[3]);
+    tmp_dir = argv[4];
+    num_threads = (argc == 6) ? atoi(argv[5]) : 1;
+    // Threads of the local sort need MPI_THREAD_FUNNELED; without it, sort
+    // with the calling thread only
+    if ((provided < MPI_THREAD_FUNNELED) && (num_threads > 1)) {
+	if (my_id == 0)
+	    printf("MPI does not provide MPI_THREAD_FUNNELED; using 1 thread per process\n");
+	num_threads = 1;
+    }
+    if ((list_size <= 0) || (run_size <= 0) || (run_size > MAX_RUN_SIZE)) {
+	if (my_id == 0)
+	    printf("List size must be positive and run size in range [%d ... %d]. Aborting ...\n", 1, MAX_RUN_SIZE);
+	exit(0);
+    }
+    if (run_size > list_size) run_size = (int) list_size;
+    num_runs = (int) ((list_size+run_size-1)/run_size);
+
+    list = (int *) malloc(run_size*sizeof(int));
+    list_capacity = run_size;
+    work = (int *) malloc(run_size*sizeof(int));
+    work_capacity = run_size;
+    num_samples = num_runs*num_procs;
+    my_samples = (int *) malloc(num_samples*sizeof(int));
+    samples = (int *) malloc((long long) num_samples*num_procs*sizeof(int));
+    splitters = (int *) malloc(num_procs*sizeof(int));
+    split = (int *) malloc((num_procs+1)*sizeof(int));
+    send_counts = (int *) malloc(num_procs*sizeof(int));
+    send_displs = (int *) malloc(num_procs*sizeof(int));
+    recv_counts = (int *) malloc(num_procs*sizeof(int));
+    recv_displs = (int *) malloc((num_procs+1)*sizeof(int));
+    run_paths = (char (*)[MAX_PATH_LENGTH]) malloc(num_runs*MAX_PATH_LENGTH);
+    part_paths = (char (*)[MAX_PATH_LENGTH]) malloc(num_runs*MAX_PATH_LENGTH);
+    for (r = 0; r < num_runs; r++) {
+	snprintf(run_paths[r], MAX_PATH_LENGTH, "%s/run_%d_%d.bin", tmp_dir, my_id, r);
+	snprintf(part_paths[r], MAX_PATH_LENGTH, "%s/part_%d_%d.bin", tmp_dir, my_id, r);
+    }
+    snprintf(out_path, MAX_PATH_LENGTH, "%s/sorted_%d.bin", tmp_dir, my_id);
+    if (type >= 0) srand48(type + my_id);
+
+    // Start External Sample Sort .............................................
+    timing_begin("external sort");
+
+    // Phase 1: sort runs, write them to files, take num_procs regular
+    // samples of each run
+    timing_begin("runs");
+    for (r = 0; r < num_runs; r++) {
+	n = (r < num_runs-1) ? run_size : (int) (list_size-(long long) r*run_size);
+	generate_run(list, (long long) r*run_size, n, list_size, type, my_id, num_procs);
+	add_list_checksum(list, n, &local_checksum);
+	local_sort_int(list, work, n, num_threads);
+	for (j = 0; j < num_procs; j++) {
+	    my_samples[r*num_procs+j] = list[(j*(long long) n)/num_procs];
+	}
+	fp = fopen(run_paths[r], "wb");
+	if (fp == NULL) {
+	    printf("Cannot open run file %s. Aborting ...\n", run_paths[r]);
+	    MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	write_block(fp, list, n);
+	fclose(fp);
+    }
+    t_runs = timing_end();
+
+    // Phase 2: choose splitters from the samples of all runs, as in
+    // sample_sort.c; samples j*num_samples ... (j+1)*num_samples-1 lie
+    // around the j/num_procs quantile
+    timing_begin("splitters and exchange");
+    MPI_Allgather(my_samples, num_samples, MPI_INT, samples, num_samples, MPI_INT, MPI_COMM_WORLD);
+    introsort_int(samples, (long) num_samples*num_procs);
+    for (j = 1; j < num_procs; j++) {
+	splitters[j-1] = samples[(long long) j*num_samples+num_samples/2];
+    }
+
+    // Phase 3: redistribute run r of all processes with one MPI_Alltoallv;
+    // merge the received pieces into run file r of the receiver
+    for (r = 0; r < num_runs; r++) {
+	n = (r < num_runs-1) ? run_size : (int) (list_size-(long long) r*run_size);
+	fp = fopen(run_paths[r], "rb");
+	if ((long long) fread(list, sizeof(int), n, fp) != n) {
+	    printf("Cannot read run file %s. Aborting ...\n", run_paths[r]);
+	    MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	fclose(fp);
+	remove(run_paths[r]);
+
+	split_at_splitters(list, n, splitters, num_procs, split);
+	for (j = 0; j < num_procs; j++) {
+	    send_counts[j] = split[j+1]-split[j];
+	    send_displs[j] = split[j];
+	}
+	MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, MPI_COMM_WORLD);
+	recv_displs[0] = 0;
+	for (j = 0; j < num_procs; j++) {
+	    recv_displs[j+1] = recv_displs[j]+recv_counts[j];
+	}
+	if (recv_displs[num_procs] > work_capacity) {
+	    free(work);
+	    work_capacity = recv_displs[num_procs];
+	    work = (int *) malloc(work_capacity*sizeof(int));
+	}
+	MPI_Alltoallv(list, send_counts, send_displs, MPI_INT,
+		work, recv_counts, recv_displs, MPI_INT, MPI_COMM_WORLD);
+	if (recv_displs[num_procs] > max_received) max_received = recv_displs[num_procs];
+
+	// Merge received pieces; list is reused as output where it fits
+	if (recv_displs[num_procs] > list_capacity) {
+	    free(list);
+	    list_capacity = recv_displs[num_procs];
+	    list = (int *) malloc(list_capacity*sizeof(int));
+	}
+	merge_runs(work, recv_displs, num_procs, list);
+	fp = fopen(part_paths[r], "wb");
+	if (fp == NULL) {
+	    printf("Cannot open run file %s. Aborting ...\n", part_paths[r]);
+	    MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	write_block(fp, list, recv_displs[num_procs]);
+	fclose(fp);
+    }
+    t_exchange = timing_end();
+
+    // Phase 4: streamed k-way merges of received runs, in passes if there
+    // are too many runs; the read/write buffers share the memory of one
+    // run, however large the received runs were
+    timing_begin("merge");
+    free(list); free(work);
+    merge_memory = run_size;
+    merged = merge_in_passes(part_paths, num_runs, merge_memory, tmp_dir, my_id, out_path);
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    t_merge = timing_end();
+    total_time = timing_end();
+    // End External Sample Sort ..............................................
+
+    if (my_id == 0) {
+	printf("[Proc: %0d] number of processes = %d, local list size = %lld, run size = %d, runs = %d, external sort time = %.9f\n",
+		my_id, num_procs, list_size, run_size, num_runs, total_time);
+    }
+    if (VERBOSE > 0) {
+	printf("[Proc: %0d] output elements = %lld, largest received run = %d, run time = %f, exchange time = %f, merge time = %f\n",
+		my_id, merged, max_received, t_runs, t_exchange, t_merge);
+    }
+
+    // Check if output files have been sorted correctly
+    global_list_checksum(&local_checksum, &checksum, MPI_COMM_WORLD);
+    check_output(out_path, merge_memory, list_size*num_procs, &checksum, my_id, num_procs);
+    if (!KEEP_OUTPUT) remove(out_path);
+
+    if (TIMING_REPORT && (my_id == 0)) timing_report(stdout);
+
+    free(my_samples); free(samples); free(splitters); free(split);
+    free(send_counts); free(send_displs); free(recv_counts); free(recv_displs);
+    free(run_paths); free(part_paths);
+    MPI_Finalize();				// Finalize MPI
+}
@@ -0,0 +1,486 @@
+// -----------------------------------------------------------------
+// Header file with a reusable hypercube quicksort
+//
+// This header is a template, like local_sort.h: define the parameters
+// below and include it once per element type/order to generate the sort
+// for that type. All comparisons, including pivot selection, are done on
+// the unsigned 64-bit order key, so ascending and descending sorts (or a
+// sort of records by one field) only differ in SORT_ORDER_KEY.
+//
+//   SORT_NAME		- suffix of generated routines (e.g. int)
+//   SORT_KEY		- element type (any type that can be copied with
+//			  memcpy; elements are sent as MPI_BYTE)
+//   SORT_ORDER_KEY(e)	- unsigned 64-bit key of element e; elements are
+//			  sorted in increasing order of this key
+//   SORT_KEY_BYTES	- number of low-order bytes of SORT_ORDER_KEY(e)
+//			  that can be nonzero (at most 8)
+//
+// Example (descending ints):
+//
+//   #define SORT_NAME		int_descending
+//   #define SORT_KEY		int
+//   #define SORT_ORDER_KEY(e)	((uint64_t) (~((uint32_t) (e) ^ 0x80000000u)))
+//   #define SORT_KEY_BYTES	4
+//   #include "hypercube_sort.h"
+//
+// Generated routines (local_sort_<SORT_NAME> and introsort_<SORT_NAME>
+// from local_sort.h are generated as well):
+//
+//   hypercube_sort_<SORT_NAME>(&list, &list_size, &list_capacity,
+//			       &work, &work_capacity, num_threads, comm)
+//	- sort the lists of all processes in communicator comm: afterwards
+//	  each local list is sorted and no element on process i is ordered
+//	  after an element on process i+1. list and work are malloc'ed
+//	  buffers holding list_capacity and work_capacity elements; both
+//	  may be replaced by larger buffers, and list_size changes. The
+//	  local sort uses num_threads threads. Returns 0, or 1 (and does
+//	  nothing) if the size of comm is not a power of 2
+//
+// Common routines:
+//
+//   free_hypercube_sort_comms(comm)
+//	- free the sub-hypercube communicators cached on comm (collective
+//	  over comm); they are also freed with comm, so this is only needed
+//	  for communicators that are never freed, such as MPI_COMM_WORLD,
+//	  before calling MPI_Finalize
+//
+// Parameters are undefined at the end of this header.
+//
+#ifndef HYPERCUBE_SORT_COMMON
+#define HYPERCUBE_SORT_COMMON
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+
+#define EXCHANGE_CHUNK_SIZE	65536	// Elements per message in sublist exchange
+#define MAX_HYPERCUBE_DIM	30	// Maximum hypercube dimension
+
+// Pivot selection strategies (see select_pivot)
+#define PIVOT_MEAN_OF_MEDIANS	0	// Mean of local medians
+#define PIVOT_WEIGHTED_MEDIAN	1	// Median of local medians weighted by list size
+#define PIVOT_SAMPLES		2	// Weighted median of regular samples of all lists
+
+#ifndef PIVOT_STRATEGY
+#define PIVOT_STRATEGY		PIVOT_SAMPLES	// Use PIVOT_STRATEGY to select pivots
+#endif
+#ifndef PIVOT_SAMPLES_PER_PROC
+#define PIVOT_SAMPLES_PER_PROC	32	// Samples per process for PIVOT_SAMPLES
+#endif
+
+#ifndef VERBOSE
+#define VERBOSE 0			// Use VERBOSE to control output
+#endif
+
+#define HYPERCUBE_SORT_CAT2(a, b)	a##_##b
+#define HYPERCUBE_SORT_CAT(a, b)	HYPERCUBE_SORT_CAT2(a, b)
+
+// Computes the rank of neighbor process along dimension k (k > 0) of
+// the hypercube. Rank is computed by flipping the kth bit of rank/id of
+// this process
+//
+int neighbor_along_dim_k(int my_id, int k) {
+    int mask = 1 << (k-1);
+    return (my_id ^ mask);
+}
+
+// Communicators for the sub-hypercubes of dimensions 0 ... dim of a
+// communicator; built on first use and cached on that communicator as an
+// attribute, so they are reused by all later sorts on it and freed (by
+// free_sub_hypercube_comms) when it is freed. A communicator freed and a
+// new one created with the same handle cannot see a stale cache, and a
+// sort on one communicator never frees the cache of another
+struct sub_hypercube_comms {
+    int dim;				// Dimension of the communicator
+    MPI_Comm comms[MAX_HYPERCUBE_DIM+1];	// comms[k]: sub-hypercube of dimension k
+};
+int sub_hypercube_comms_keyval = MPI_KEYVAL_INVALID;	// Attribute key of the cache
+
+// Attribute delete callback: frees the cached communicators (called by
+// MPI_Comm_free and MPI_Comm_delete_attr on the base communicator, so
+// collective over it)
+int free_sub_hypercube_comms(MPI_Comm comm, int keyval, void *attribute_val, void *extra_state) {
+    struct sub_hypercube_comms * cache = (struct sub_hypercube_comms *) attribute_val;
+    int k;
+    (void) comm; (void) keyval; (void) extra_state;
+    for (k = cache->dim; k >= 0; k--) {
+	MPI_Comm_free(&cache->comms[k]);
+    }
+    free(cache);
+    return MPI_SUCCESS;
+}
+
+// Frees the sub-hypercube communicators cached on comm, if any (collective)
+void free_hypercube_sort_comms(MPI_Comm comm) {
+    void * cache;
+    int flag;
+    if (sub_hypercube_comms_keyval == MPI_KEYVAL_INVALID) return;
+    MPI_Comm_get_attr(comm, sub_hypercube_comms_keyval, &cache, &flag);
+    if (flag) MPI_Comm_delete_attr(comm, sub_hypercube_comms_keyval);
+}
+
+// Returns communicator for the sub-hypercube of dimension k of comm that
+// includes this process; it includes all processes with ranks that differ
+// from this process in the lowest k bits only, and the rank of this
+// process in it is the lowest k bits of its rank in comm
+// The communicators for all dimensions are built together the first time
+// (collective over comm): the dim-(k-1) communicator is split from the
+// dim-k communicator by bit k-1 of the rank, so each split only involves
+// the processes of one sub-hypercube
+//
+MPI_Comm sub_hypercube_comm(int k, int dim, MPI_Comm comm) {
+    struct sub_hypercube_comms * cache;
+    int j, my_id, flag;
+    if (sub_hypercube_comms_keyval == MPI_KEYVAL_INVALID) {
+	MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, free_sub_hypercube_comms,
+		&sub_hypercube_comms_keyval, NULL);
+    }
+    MPI_Comm_get_attr(comm, sub_hypercube_comms_keyval, &cache, &flag);
+    if (flag && (cache->dim == dim)) return cache->comms[k];
+    if (flag) MPI_Comm_delete_attr(comm, sub_hypercube_comms_keyval);
+    cache = (struct sub_hypercube_comms *) malloc(sizeof(struct sub_hypercube_comms));
+    cache->dim = dim;
+    MPI_Comm_rank(comm, &my_id);
+    MPI_Comm_dup(comm, &cache->comms[dim]);
+    for (j = dim; j > 0; j--) {
+	MPI_Comm_split(cache->comms[j], (my_id >> (j-1)) & 1, my_id, &cache->comms[j-1]);
+    }
+    MPI_Comm_set_attr(comm, sub_hypercube_comms_keyval, cache);
+    return cache->comms[k];
+}
+
+// Comparison routine for qsort (stdlib.h) used to sort pivot samples,
+// which are (order key, weight) pairs, by order key
+//
+int compare_sample(const void *a0, const void *b0) {
+    uint64_t a = ((uint64_t *)a0)[0];
+    uint64_t b = ((uint64_t *)b0)[0];
+    return (a < b) ? -1 : (a > b) ? 1 : 0;
+}
+
+// Select pivot (an order key) from order keys sampled by the processes
+// in communicator comm
+// Strategy is set by PIVOT_STRATEGY:
+//   PIVOT_MEAN_OF_MEDIANS - mean of the medians of the non-empty lists
+//			     (high and low 32 bits are summed separately,
+//			     so the sum cannot overflow)
+//   PIVOT_WEIGHTED_MEDIAN - median of the local medians, each weighted by
+//			     the size of its list
+//   PIVOT_SAMPLES	   - each process takes PIVOT_SAMPLES_PER_PROC samples
+//			     at regular positions of its list; the pivot is
+//			     the median of all samples, each weighted by the
+//			     size of its list
+// Input:
+//   my_samples		- (order key, list_size) pairs of this process: 1
+//			  (the median) or PIVOT_SAMPLES_PER_PROC pairs
+//   list_size		- size of local list
+//   comm, comm_size	- communicator of the sub-hypercube and its size
+// Output:
+//   pivot
+//
+uint64_t select_pivot(uint64_t *my_samples, int list_size, MPI_Comm comm, int comm_size) {
+    uint64_t local[3], global[3];
+    uint64_t * samples;			// (order key, weight) pairs of all processes
+    uint64_t total_weight, weight, pivot;
+    int num_samples, j;
+
+    if (PIVOT_STRATEGY == PIVOT_MEAN_OF_MEDIANS) {
+	local[0] = (list_size > 0) ? (my_samples[0] >> 32) : 0;
+	local[1] = (list_size > 0) ? (my_samples[0] & 0xffffffffu) : 0;
+	local[2] = (list_size > 0) ? 1 : 0;
+	MPI_Allreduce(local, global, 3, MPI_UINT64_T, MPI_SUM, comm);
+	if (global[2] == 0) return 0;
+	return ((global[0]/global[2]) << 32)
+	    + (((global[0]%global[2]) << 32) + global[1])/global[2];
+    }
+
+    num_samples = (PIVOT_STRATEGY == PIVOT_SAMPLES) ? PIVOT_SAMPLES_PER_PROC : 1;
+    samples = (uint64_t *) malloc(2*num_samples*comm_size*sizeof(uint64_t));
+    MPI_Allgather(my_samples, 2*num_samples, MPI_UINT64_T, samples, 2*num_samples, MPI_UINT64_T, comm);
+    qsort(samples, num_samples*comm_size, 2*sizeof(uint64_t), compare_sample);
+
+    total_weight = 0;
+    for (j = 0; j < num_samples*comm_size; j++) total_weight += samples[2*j+1];
+    weight = 0;
+    for (j = 0; j < num_samples*comm_size; j++) {
+	weight += samples[2*j+1];
+	if (2*weight >= total_weight) break;
+    }
+    j = (j < num_samples*comm_size) ? j : num_samples*comm_size-1;
+    pivot = samples[2*j];
+    free(samples);
+    return pivot;
+}
+
+// Print size of the local list of every process in comm, and the load
+// imbalance (largest size / average size), after splitting along dimension k
+// Input:
+//   list_size		- size of local list
+//   k			- dimension
+//   comm		- communicator of the sort
+//
+void print_list_sizes(int list_size, int k, MPI_Comm comm) {
+    int * sizes = NULL;
+    int j, max_size = 0, my_id, num_procs;
+    long long total = 0;
+    MPI_Comm_rank(comm, &my_id);
+    MPI_Comm_size(comm, &num_procs);
+    if (my_id == 0) sizes = (int *) malloc(num_procs*sizeof(int));
+    MPI_Gather(&list_size, 1, MPI_INT, sizes, 1, MPI_INT, 0, comm);
+    if (my_id == 0) {
+	for (j = 0; j < num_procs; j++) {
+	    total += sizes[j];
+	    if (sizes[j] > max_size) max_size = sizes[j];
+	}
+	printf("[Proc: %0d] dimension %d: max list size = %d, imbalance = %.3f, list sizes =",
+		my_id, k, max_size, (total > 0) ? max_size*(double)num_procs/total : 1.0);
+	for (j = 0; j < num_procs; j++) printf(" %d", sizes[j]);
+	printf("\n");
+	free(sizes);
+    }
+}
+
+#endif
+
+#define HYPERCUBE_SORT_FN(f)	HYPERCUBE_SORT_CAT(f, SORT_NAME)
+
+// Generated by local_sort.h at the end of this header
+void HYPERCUBE_SORT_FN(local_sort)(SORT_KEY *list, SORT_KEY *scratch, long n, int num_threads);
+
+// -----------------------------------------------------------------
+// Routines for SORT_KEY
+
+// Exchange sublists with neighbor process and merge the received sublist
+// with the kept local sublist while it is in transit
+// The neighbor's sublist is received in chunks of EXCHANGE_CHUNK_SIZE
+// elements directly into list[keep_size ...], behind room for the kept
+// sublist; all chunks are posted with MPI_Isend/MPI_Irecv up front, and
+// each chunk is merged as soon as it arrives. The merge writes from the
+// front of list and never overtakes the part of the received sublist that
+// has not been merged yet, so no separate output array is needed.
+// Input:
+//   send_list, send_size	- local sublist sent to neighbor
+//   keep_list, keep_size	- local sublist kept by this process
+//   nbr_list_size		- size of sublist received from neighbor
+//   nbr, comm			- neighbor rank in communicator comm
+// Output:
+//   list			- merged list of keep_size+nbr_list_size
+//				  elements (must not overlap the local lists)
+//
+void HYPERCUBE_SORT_FN(exchange_and_merge)(SORT_KEY * send_list, int send_size,
+	SORT_KEY * keep_list, int keep_size,
+	SORT_KEY * list, int nbr_list_size, int nbr, MPI_Comm comm) {
+    int num_send = (send_size+EXCHANGE_CHUNK_SIZE-1)/EXCHANGE_CHUNK_SIZE;
+    int num_recv = (nbr_list_size+EXCHANGE_CHUNK_SIZE-1)/EXCHANGE_CHUNK_SIZE;
+    MPI_Request * requests = (MPI_Request *) malloc((num_send+num_recv+1)*sizeof(MPI_Request));
+    MPI_Request * recv_requests = &requests[num_send];
+    SORT_KEY * nbr_list = &list[keep_size];
+    int received = 0;		// Number of elements of nbr_list received
+    int idx1 = 0;
+    int idx2 = 0;
+    int idx = 0;
+    int c, count;
+
+    for (c = 0; c < num_recv; c++) {
+	count = (c < num_recv-1) ? EXCHANGE_CHUNK_SIZE : nbr_list_size-c*EXCHANGE_CHUNK_SIZE;
+	MPI_Irecv(&nbr_list[c*EXCHANGE_CHUNK_SIZE], count*(int)sizeof(SORT_KEY), MPI_BYTE,
+		nbr, 0, comm, &recv_requests[c]);
+    }
+    for (c = 0; c < num_send; c++) {
+	count = (c < num_send-1) ? EXCHANGE_CHUNK_SIZE : send_size-c*EXCHANGE_CHUNK_SIZE;
+	MPI_Isend(&send_list[c*EXCHANGE_CHUNK_SIZE], count*(int)sizeof(SORT_KEY), MPI_BYTE,
+		nbr, 0, comm, &requests[c]);
+    }
+
+    for (c = 0; c < num_recv; c++) {
+	MPI_Wait(&recv_requests[c], MPI_STATUS_IGNORE);
+	received += (c < num_recv-1) ? EXCHANGE_CHUNK_SIZE : nbr_list_size-c*EXCHANGE_CHUNK_SIZE;
+	// Merge up to the last element received so far
+	while ((idx1 < keep_size) && (idx2 < received)) {
+	    if (SORT_ORDER_KEY(keep_list[idx1]) <= SORT_ORDER_KEY(nbr_list[idx2])) {
+		list[idx] = keep_list[idx1];
+		idx++; idx1++;
+	    } else {
+		list[idx] = nbr_list[idx2];
+		idx++; idx2++;
+	    }
+	}
+    }
+    while (idx1 < keep_size) {
+	list[idx] = keep_list[idx1];
+	idx++; idx1++;
+    }
+    // Remaining elements of nbr_list are already in place
+
+    MPI_Waitall(num_send, requests, MPI_STATUSES_IGNORE);
+    free(requests);
+}
+
+// Make sure a list buffer can hold size elements
+// Buffers only grow, and their contents are not preserved when they do;
+// the two buffers of a process are reused for all dimensions
+// Input:
+//   buffer, capacity	- buffer and the number of elements it can hold
+//   size		- number of elements needed
+//
+void HYPERCUBE_SORT_FN(reserve_list_buffer)(SORT_KEY ** buffer, int * capacity, int size) {
+    if (size > *capacity) {
+	free(*buffer);
+	*buffer = (SORT_KEY *) malloc(size*sizeof(SORT_KEY));
+	*capacity = size;
+    }
+}
+
+// Search for smallest element in a sorted list whose order key is larger
+// than pivot
+// Uses binary search since list is sorted.
+// Input:
+//   list, list_size	- list and its size
+//   pivot		- order key to search for
+// Output:
+//   last 	- index of the smallest element that is larger than the pivot
+//
+int HYPERCUBE_SORT_FN(split_list_index)(SORT_KEY *list, int list_size, uint64_t pivot) {
+    int first, last, mid;
+    first = 0; last = list_size; mid = (first+last)/2;
+    while (first < last) {
+	if (SORT_ORDER_KEY(list[mid]) <= pivot) {
+	    first = mid+1; mid = (first+last)/2;
+	} else {
+	    last = mid; mid = (first+last)/2;
+	}
+    }
+    return last;
+}
+
+// Hypercube quicksort of the lists of all processes in comm (see top of
+// this header for arguments)
+//
+int HYPERCUBE_SORT_FN(hypercube_sort)(SORT_KEY ** list_ptr, int * list_size_ptr,
+	int * list_capacity_ptr, SORT_KEY ** work_ptr, int * work_capacity_ptr,
+	int num_threads, MPI_Comm comm) {
+    SORT_KEY * list = *list_ptr;	// Local list
+    int list_size = *list_size_ptr;	// Local list size
+    int list_capacity = *list_capacity_ptr;	// Number of elements list can hold
+    SORT_KEY * work = *work_ptr;	// Second list buffer: local sort scratch,
+    					// then receives nbr sublist and holds
+					// merge of it with local sublist
+    int work_capacity = *work_capacity_ptr;	// Number of elements work can hold
+
+    int dim;			// Hypercube dimension
+    int k; 			// Sub hypercube dimension
+    int nbr_k; 			// Neighbor of this process along dim-k
+
+    uint64_t my_samples[2*PIVOT_SAMPLES_PER_PROC];	// (order key, weight) pairs
+    int num_samples;		// Number of pivot samples of this process
+    uint64_t pivot;		// Order key used to split local list
+    int idx;			// index where local list is split
+    int list_size_leq;		// Number of elements <= pivot
+    int list_size_gt;		// Number of elements > pivot
+    int nbr_list_size;		// Size of sublist received from nbr process
+    SORT_KEY * keep_list;	// Local sublist kept by this process
+    int keep_size;		// keep_list size
+    SORT_KEY * send_list;	// Local sublist sent to nbr process
+    int send_size;		// send_list size
+    SORT_KEY * swap;
+    int i, j;
+
+    int num_procs; 		// Number of processes in comm
+    int my_id;			// Rank/id of this process in comm
+
+    // Hypercube communicator variables to facilitate pivot computation
+    // The communicator for the hypercube of dimension k includes all
+    // processes with ranks that differ from this process in the lowest k
+    // bits only (see sub_hypercube_comm)
+    //
+    int sub_hypercube_size; 		// Number of processors in dim-k hypercube
+    MPI_Comm comm_k;			// Communicator for dim-k hypercube
+
+    MPI_Comm_size(comm, &num_procs);
+    MPI_Comm_rank(comm, &my_id);
+
+    // Compute hypercube dimension: 2^dim = num_procs
+    for (dim = 0; (1 << dim) < num_procs; dim++);
+    if ((num_procs != (1 << dim)) || (dim > MAX_HYPERCUBE_DIM)) {
+	return 1;
+    }
+
+    // Sort local list, using work buffer as scratch
+    HYPERCUBE_SORT_FN(reserve_list_buffer)(&work, &work_capacity, list_size);
+    HYPERCUBE_SORT_FN(local_sort)(list, work, list_size, num_threads);
+
+    // Hypercube Quicksort
+    num_samples = (PIVOT_STRATEGY == PIVOT_SAMPLES) ? PIVOT_SAMPLES_PER_PROC : 1;
+    for (k = dim; k > 0; k--) {
+
+	// Get (cached) communicator for sub-hypercube of dimension k that
+	// includes this process; it simplifies computation of pivot via
+	// collectives within the sub-hypercube
+	sub_hypercube_size = 1 << k;
+	comm_k = sub_hypercube_comm(k, dim, comm);
+
+	// Compute pivot for hypercube of dimension k from samples of the
+	// local list at regular positions (a single sample is the median)
+	for (j = 0; j < num_samples; j++) {
+	    my_samples[2*j] = (list_size > 0) ?
+		SORT_ORDER_KEY(list[((2*j+1)*(long long)list_size)/(2*num_samples)]) : 0;
+	    my_samples[2*j+1] = list_size;
+	}
+	pivot = select_pivot(my_samples, list_size, comm_k, sub_hypercube_size);
+
+	// Search for smallest element in list which is larger than pivot
+	// Upon return:
+	//   list[0 ... idx-1] <= pivot
+	//   list[idx ... list_size-1] > pivot
+	idx = HYPERCUBE_SORT_FN(split_list_index)(list, list_size, pivot);
+
+	list_size_leq = idx;
+	list_size_gt = list_size - idx;
+
+	// Communicate with neighbor along dimension k
+	nbr_k = neighbor_along_dim_k(my_id, k);
+
+	// Process with the smaller rank keeps elements less than or equal to
+	// the pivot and sends the rest; its neighbor does the opposite
+	if (nbr_k > my_id) {
+	    keep_list = list; keep_size = list_size_leq;
+	    send_list = &list[idx]; send_size = list_size_gt;
+	} else {
+	    keep_list = &list[idx]; keep_size = list_size_gt;
+	    send_list = list; send_size = list_size_leq;
+	}
+	nbr_k = nbr_k % sub_hypercube_size;
+
+	// Exchange sublist sizes with neighbor
+	MPI_Sendrecv(&send_size, 1, MPI_INT, nbr_k, 0, &nbr_list_size, 1, MPI_INT, nbr_k, 0,
+		comm_k, MPI_STATUS_IGNORE);
+
+	// Make room in work buffer for local sublist and neighbor's list
+	HYPERCUBE_SORT_FN(reserve_list_buffer)(&work, &work_capacity, keep_size+nbr_list_size);
+
+	// Exchange sublists, merging kept sublist with neighbor's sublist
+	// into work buffer as it arrives
+	HYPERCUBE_SORT_FN(exchange_and_merge)(send_list, send_size, keep_list, keep_size,
+		work, nbr_list_size, nbr_k, comm_k);
+
+	// Swap list buffers, update size
+	swap = list; list = work; work = swap;
+	i = list_capacity; list_capacity = work_capacity; work_capacity = i;
+	list_size = keep_size+nbr_list_size;
+
+	if (VERBOSE > 0) {
+	    print_list_sizes(list_size, k, comm);
+	}
+    }
+
+    *list_ptr = list; *list_size_ptr = list_size; *list_capacity_ptr = list_capacity;
+    *work_ptr = work; *work_capacity_ptr = work_capacity;
+    return 0;
+}
+
+#undef HYPERCUBE_SORT_FN
+
+// Generate local_sort_<SORT_NAME> and introsort_<SORT_NAME>; undefines
+// the parameters
+#include "local_sort.h"
@@ -0,0 +1,114 @@
+// -----------------------------------------------------------------
+// Header file with an order-independent checksum (multiset fingerprint)
+// of a distributed list
+//
+// Every element is hashed; the checksum is the sum and the xor of the
+// hashes, and the number of elements. It does not depend on the order of
+// the elements or on how they are distributed over the processes, so the
+// checksums of a list before and after sorting must be equal. A dropped,
+// duplicated or changed element changes the sum (and almost always the
+// xor) with probability close to 1.
+//
+// Contains following routines
+//
+//   hash_element(value)
+//	- 64-bit hash of an element
+//
+//   local_list_checksum(list, list_size, &checksum)
+//	- checksum of the local list
+//
+//   add_list_checksum(list, list_size, &checksum)
+//	- add elements to a local checksum (lists checksummed in parts)
+//
+//   global_list_checksum(&local, &checksum, comm)
+//	- combine local checksums of all processes in comm
+//
+//   list_checksum(list, list_size, &checksum, comm)
+//	- checksum of the lists of all processes in comm (MPI_Allreduce)
+//
+//   key_checksum(records, num_records, record_size, key_offset, &checksum, comm)
+//	- checksum of the unsigned 64-bit keys at byte offset key_offset of
+//	  the records of all processes in comm
+//
+//   list_checksum_equal(&a, &b)
+//	- 1 if two checksums are equal
+//
+#ifndef LIST_CHECKSUM_H
+#define LIST_CHECKSUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "mpi.h"
+
+struct list_checksum {
+    uint64_t sum;			// Sum of hashes (mod 2^64)
+    uint64_t xor;			// Xor of hashes
+    uint64_t count;			// Number of elements
+};
+
+// Hash of an element (finalizer of the splitmix64 generator); equal values
+// have equal hashes, nearby values have unrelated hashes
+static inline uint64_t hash_element(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+void add_list_checksum(int *list, int list_size, struct list_checksum *checksum) {
+    uint64_t sum = 0, xor = 0, h;
+    int j;
+    for (j = 0; j < list_size; j++) {
+	h = hash_element((uint64_t) (uint32_t) list[j]);
+	sum += h;
+	xor ^= h;
+    }
+    checksum->sum += sum;
+    checksum->xor ^= xor;
+    checksum->count += (uint64_t) list_size;
+}
+
+void local_list_checksum(int *list, int list_size, struct list_checksum *checksum) {
+    checksum->sum = checksum->xor = checksum->count = 0;
+    add_list_checksum(list, list_size, checksum);
+}
+
+void global_list_checksum(struct list_checksum *local, struct list_checksum *checksum,
+	MPI_Comm comm) {
+    uint64_t sums[2], global_sums[2];
+    sums[0] = local->sum; sums[1] = local->count;
+    MPI_Allreduce(sums, global_sums, 2, MPI_UINT64_T, MPI_SUM, comm);
+    MPI_Allreduce(&local->xor, &checksum->xor, 1, MPI_UINT64_T, MPI_BXOR, comm);
+    checksum->sum = global_sums[0];
+    checksum->count = global_sums[1];
+}
+
+void list_checksum(int *list, int list_size, struct list_checksum *checksum, MPI_Comm comm) {
+    struct list_checksum local;
+    local_list_checksum(list, list_size, &local);
+    global_list_checksum(&local, checksum, comm);
+}
+
+// Keys are copied with memcpy, as they need not be aligned
+void key_checksum(const char *records, int num_records, size_t record_size, size_t key_offset,
+	struct list_checksum *checksum, MPI_Comm comm) {
+    struct list_checksum local;
+    uint64_t key, h;
+    int j;
+    local.sum = local.xor = 0;
+    for (j = 0; j < num_records; j++) {
+	memcpy(&key, &records[j*record_size+key_offset], sizeof(uint64_t));
+	h = hash_element(key);
+	local.sum += h;
+	local.xor ^= h;
+    }
+    local.count = (uint64_t) num_records;
+    global_list_checksum(&local, checksum, comm);
+}
+
+int list_checksum_equal(struct list_checksum *a, struct list_checksum *b) {
+    return (a->sum == b->sum) && (a->xor == b->xor) && (a->count == b->count);
+}
+
+#endif
@@ -0,0 +1,246 @@
+// -----------------------------------------------------------------
+// Header file with type-specialized local sort routines
+//
+// This header is a template: define the parameters below and include
+// it once per element type/order to generate the sort routines for that
+// type. Comparisons are expanded inline (no qsort() function pointer).
+//
+//   SORT_NAME		- suffix of generated routines (e.g. int)
+//   SORT_KEY		- element type
+//   SORT_ORDER_KEY(e)	- unsigned 64-bit key of element e; elements are
+//			  sorted in increasing order of this key
+//   SORT_KEY_BYTES	- number of low-order bytes of SORT_ORDER_KEY(e)
+//			  that can be nonzero (at most 8)
+//
+// Example (ascending ints):
+//
+//   #define SORT_NAME		int
+//   #define SORT_KEY		int
+//   #define SORT_ORDER_KEY(e)	((uint64_t) ((uint32_t) (e) ^ 0x80000000u))
+//   #define SORT_KEY_BYTES	4
+//   #include "local_sort.h"
+//
+// Generated routines:
+//
+//   local_sort_<SORT_NAME>(list, scratch, n, num_threads)
+//	- sort list[0 ... n-1]; scratch must hold n elements. Uses an LSD
+//	  radix sort on SORT_ORDER_KEY with num_threads threads (skipping
+//	  bytes that are equal in all keys), or introsort for small lists
+//
+//   introsort_<SORT_NAME>(list, n)
+//	- sequential introsort (quicksort, heapsort fallback, insertion sort)
+//
+// Parameters are undefined at the end of this header.
+//
+#ifndef LOCAL_SORT_COMMON
+#define LOCAL_SORT_COMMON
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SORT_THREADS	256	// Maximum no. of threads per local sort
+#define RADIX_MIN_SIZE		4096	// Smaller lists use introsort
+#define INSERTION_SORT_SIZE	16	// Smaller partitions use insertion sort
+
+#define LOCAL_SORT_CAT2(a, b)	a##_##b
+#define LOCAL_SORT_CAT(a, b)	LOCAL_SORT_CAT2(a, b)
+
+#endif
+
+#define LOCAL_SORT_FN(f)	LOCAL_SORT_CAT(f, SORT_NAME)
+#define LOCAL_SORT_LESS(a, b)	(SORT_ORDER_KEY(a) < SORT_ORDER_KEY(b))
+
+// -----------------------------------------------------------------
+// Introsort
+
+static void LOCAL_SORT_FN(insertion_sort)(SORT_KEY *list, long n) {
+    long i, j;
+    SORT_KEY e;
+    for (i = 1; i < n; i++) {
+	e = list[i];
+	for (j = i; (j > 0) && LOCAL_SORT_LESS(e, list[j-1]); j--) {
+	    list[j] = list[j-1];
+	}
+	list[j] = e;
+    }
+}
+
+static void LOCAL_SORT_FN(sift_down)(SORT_KEY *list, long root, long n) {
+    long child;
+    SORT_KEY e = list[root];
+    while ((child = 2*root+1) < n) {
+	if ((child+1 < n) && LOCAL_SORT_LESS(list[child], list[child+1])) child++;
+	if (!LOCAL_SORT_LESS(e, list[child])) break;
+	list[root] = list[child];
+	root = child;
+    }
+    list[root] = e;
+}
+
+static void LOCAL_SORT_FN(heap_sort)(SORT_KEY *list, long n) {
+    long i;
+    SORT_KEY e;
+    for (i = n/2-1; i >= 0; i--) {
+	LOCAL_SORT_FN(sift_down)(list, i, n);
+    }
+    for (i = n-1; i > 0; i--) {
+	e = list[0]; list[0] = list[i]; list[i] = e;
+	LOCAL_SORT_FN(sift_down)(list, 0, i);
+    }
+}
+
+static void LOCAL_SORT_FN(introsort_loop)(SORT_KEY *list, long n, int depth) {
+    long i, j, mid;
+    SORT_KEY pivot, e;
+    while (n > INSERTION_SORT_SIZE) {
+	if (depth-- == 0) {
+	    LOCAL_SORT_FN(heap_sort)(list, n);
+	    return;
+	}
+	// Median of three, moved to list[0]
+	mid = n/2;
+	if (LOCAL_SORT_LESS(list[mid], list[0])) { e = list[mid]; list[mid] = list[0]; list[0] = e; }
+	if (LOCAL_SORT_LESS(list[n-1], list[mid])) { e = list[mid]; list[mid] = list[n-1]; list[n-1] = e; }
+	if (LOCAL_SORT_LESS(list[mid], list[0])) { e = list[mid]; list[mid] = list[0]; list[0] = e; }
+	e = list[mid]; list[mid] = list[0]; list[0] = e;
+	pivot = list[0];
+	// Hoare partition of list[1 ... n-1]
+	i = 0; j = n;
+	for (;;) {
+	    do { i++; } while ((i < n) && LOCAL_SORT_LESS(list[i], pivot));
+	    do { j--; } while (LOCAL_SORT_LESS(pivot, list[j]));
+	    if (i >= j) break;
+	    e = list[i]; list[i] = list[j]; list[j] = e;
+	}
+	list[0] = list[j]; list[j] = pivot;
+	// Recurse into smaller part, loop on larger part
+	if (j < n-1-j) {
+	    LOCAL_SORT_FN(introsort_loop)(list, j, depth);
+	    list += j+1; n -= j+1;
+	} else {
+	    LOCAL_SORT_FN(introsort_loop)(list+j+1, n-j-1, depth);
+	    n = j;
+	}
+    }
+    LOCAL_SORT_FN(insertion_sort)(list, n);
+}
+
+void LOCAL_SORT_FN(introsort)(SORT_KEY *list, long n) {
+    int depth = 0;
+    long m;
+    for (m = n; m > 1; m >>= 1) depth += 2;
+    LOCAL_SORT_FN(introsort_loop)(list, n, depth);
+}
+
+// -----------------------------------------------------------------
+// Multithreaded LSD radix sort
+//
+// Each thread owns a contiguous block of the list. For each byte of the
+// key, threads count their bytes (count[thread][bucket]), wait at a
+// barrier, compute where their elements of each bucket go, and scatter
+// their block from src to dst. A byte with all keys in one bucket is
+// skipped.
+
+struct LOCAL_SORT_FN(radix_job) {
+    SORT_KEY *list, *scratch;
+    long n;
+    int num_threads;
+    long (*count)[256];			// count[thread][bucket]
+    pthread_barrier_t barrier;
+};
+
+struct LOCAL_SORT_FN(radix_arg) {
+    struct LOCAL_SORT_FN(radix_job) *job;
+    int id;
+};
+
+static void *LOCAL_SORT_FN(radix_thread)(void *s) {
+    struct LOCAL_SORT_FN(radix_arg) *arg = (struct LOCAL_SORT_FN(radix_arg) *) s;
+    struct LOCAL_SORT_FN(radix_job) *job = arg->job;
+    int id = arg->id;
+    long first = (job->n*id)/job->num_threads;
+    long last = (job->n*(id+1))/job->num_threads;
+    SORT_KEY *src = job->list, *dst = job->scratch, *tmp;
+    long offset[256], total, i;
+    int byte, b, t, shift, skip;
+
+    for (byte = 0; byte < SORT_KEY_BYTES; byte++) {
+	shift = 8*byte;
+	memset(job->count[id], 0, 256*sizeof(long));
+	for (i = first; i < last; i++) {
+	    job->count[id][(SORT_ORDER_KEY(src[i]) >> shift) & 0xff]++;
+	}
+	pthread_barrier_wait(&job->barrier);
+
+	// Offset of this thread's elements in each bucket: all elements of
+	// smaller buckets, plus elements of this bucket in earlier blocks
+	total = 0; skip = 0;
+	for (b = 0; b < 256; b++) {
+	    long bucket_total = 0;
+	    for (t = 0; t < job->num_threads; t++) {
+		if (t == id) offset[b] = total + bucket_total;
+		bucket_total += job->count[t][b];
+	    }
+	    if (bucket_total == job->n) skip = 1;
+	    total += bucket_total;
+	}
+	if (!skip) {
+	    for (i = first; i < last; i++) {
+		dst[offset[(SORT_ORDER_KEY(src[i]) >> shift) & 0xff]++] = src[i];
+	    }
+	    tmp = src; src = dst; dst = tmp;
+	}
+	// Counts are reused by the next byte; scatter must finish first
+	pthread_barrier_wait(&job->barrier);
+    }
+    // Sorted list ended up in scratch; copy this thread's block back
+    if (src != job->list) {
+	memcpy(&job->list[first], &src[first], (last-first)*sizeof(SORT_KEY));
+    }
+    return NULL;
+}
+
+void LOCAL_SORT_FN(local_sort)(SORT_KEY *list, SORT_KEY *scratch, long n, int num_threads) {
+    struct LOCAL_SORT_FN(radix_job) job;
+    struct LOCAL_SORT_FN(radix_arg) args[MAX_SORT_THREADS];
+    pthread_t threads[MAX_SORT_THREADS];
+    int t;
+
+    if (n < RADIX_MIN_SIZE) {
+	LOCAL_SORT_FN(introsort)(list, n);
+	return;
+    }
+    if (num_threads < 1) num_threads = 1;
+    if (num_threads > MAX_SORT_THREADS) num_threads = MAX_SORT_THREADS;
+    if (num_threads > n/RADIX_MIN_SIZE) num_threads = n/RADIX_MIN_SIZE;
+
+    job.list = list;
+    job.scratch = scratch;
+    job.n = n;
+    job.num_threads = num_threads;
+    job.count = (long (*)[256]) malloc(num_threads*sizeof(*job.count));
+    pthread_barrier_init(&job.barrier, NULL, num_threads);
+    for (t = 0; t < num_threads; t++) {
+	args[t].job = &job;
+	args[t].id = t;
+    }
+    // Calling thread works on block 0
+    for (t = 1; t < num_threads; t++) {
+	pthread_create(&threads[t], NULL, LOCAL_SORT_FN(radix_thread), (void *) &args[t]);
+    }
+    LOCAL_SORT_FN(radix_thread)((void *) &args[0]);
+    for (t = 1; t < num_threads; t++) {
+	pthread_join(threads[t], NULL);
+    }
+    pthread_barrier_destroy(&job.barrier);
+    free(job.count);
+}
+
+#undef LOCAL_SORT_FN
+#undef LOCAL_SORT_LESS
+#undef SORT_NAME
+#undef SORT_KEY
+#undef SORT_ORDER_KEY
+#undef SORT_KEY_BYTES
@@ -1,9 +1,11 @@
 // -----------------------------------------------------------------
 // Header file with routines to:
 // - initialize the list that needs to be sorted
-// - check that the list is sorted
+// - check that the list is sorted and is a permutation of the initial list
+// - print the list (for debugging)
 //
 #include "mpi.h"
+#include "list_checksum.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <limits.h>
@@ -52,6 +54,9 @@ int * initialize_list(int list_size, int type, int my_id, int num_procs) {
 // Each process verifies that its local list is sorted in ascending order.
 // The process also checks that its list has values larger than or equal to
 // the largest value on the process before it (i.e., on process (my_id-1).
+// Finally, the checksum of the lists of all processes (list_checksum.h) is 
+// compared with the checksum of the initial lists, so that a sort that 
+// drops, duplicates or changes elements is detected.
 // Prints result of error check if VERBOSE > 1 
 // Input: 
 //   list_size 	- size of list
@@ -59,8 +64,10 @@ int * initialize_list(int list_size, int type, int my_id, int num_procs) {
 //  		  decreasing order, random, other types can be added)
 //   my_id	- process rank 
 //   num_procs	- number of MPI processes
+//   checksum	- checksum of the initial lists (before sorting)
 //
-void check_list(int *list, int list_size, int my_id, int num_procs) {
+void check_list(int *list, int list_size, int my_id, int num_procs, struct list_checksum *checksum) {
+    struct list_checksum final_checksum;
     int tag = 0;
     int min_nbr = INT_MAX;		// Assumes list contains non-negative integers; 6-21-2017
     int error, local_error;
@@ -96,11 +103,44 @@ void check_list(int *list, int list_size, int my_id, int num_procs) {
     // Collect errors from all processes
     // error = 0;
     MPI_Reduce(&local_error, &error, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    // Compare checksum of sorted lists with checksum of initial lists
+    list_checksum(list, list_size, &final_checksum, MPI_COMM_WORLD);
     if (my_id == 0) {
-	if (error == 0) {
+	if ((error == 0) && list_checksum_equal(checksum, &final_checksum)) {
 	    printf("[Proc: %0d] Congratulations. The list has been sorted correctly.\n", my_id);
-	} else {
+	} else if (error != 0) {
 	    printf("[Proc: %0d] Error encountered. The list has not been sorted correctly.\n", my_id);
 	}
+	if (!list_checksum_equal(checksum, &final_checksum)) {
+	    printf("[Proc: %0d] Error encountered. The list is not a permutation of the initial list.\n", my_id);
+	}
+    }
+}
+
+// Print local list
+//
+void print_local_list(int *list, int list_size, int my_id) {
+    int j;
+    for (j = 0; j < list_size; j++) {
+	if ((j % 8) == 0) printf("[Proc: %0d]", my_id);
+	printf(" %8d", list[j]); 
+	if ((j % 8) == 7) printf("\n"); 
+    }
+    printf("\n"); 
+    return;
+}
+
+// Print list: processes print local lists in order of their ranks (from 0 to p-1)
+//
+void print_list(int *list, int list_size, int my_id, int num_procs) {
+    int tag = 0;
+    int dummy = 0;
+    MPI_Status status; 
+    if (my_id-1 >= 0) {
+	MPI_Recv(&dummy, 1, MPI_INT, my_id-1, tag, MPI_COMM_WORLD, &status);
+    }
+    print_local_list(list, list_size, my_id); 
+    if (my_id+1 < num_procs) {
+	MPI_Send(&dummy, 1, MPI_INT, my_id+1, tag, MPI_COMM_WORLD);
     }
 }
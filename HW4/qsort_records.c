@@ -0,0 +1,249 @@
+// -----------------------------------------------------------------------------
+// Hypercube Quicksort to sort records with 64-bit keys distributed across
+// processors
+// MPI-based implementation
+//
+// Each record has a 64-bit key followed by a payload; RECORD_SIZE (bytes,
+// at least 16) is set at compile time. Two methods can be compared:
+//   0 - tag sort (sort_records in record_sort.h): only keys and origin
+//	 indices go through the hypercube, payloads move once at the end
+//   1 - whole records go through the hypercube (hypercube_sort.h)
+//
+// Compilation command on ADA:
+//
+//   module load intel/2017A
+//   mpiicc -o qsort_records.exe qsort_records.c -lpthread
+//   mpiicc -DRECORD_SIZE=256 -o qsort_records_256.exe qsort_records.c -lpthread
+//
+// Routines:
+//   initialize_records	- allocate and initialize local records
+//   check_records	- check that records are sorted, complete and intact
+//   main		- main program that sorts the records
+//
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "mpi.h"
+#include "list_checksum.h"
+#include "../common/timing.h"
+
+#define MAX_LIST_SIZE_PER_PROC	268435456
+
+#ifndef RECORD_SIZE
+#define RECORD_SIZE	64		// Record size in bytes
+#endif
+
+#ifndef VERBOSE
+#define VERBOSE 0			// Use VERBOSE to control output
+#endif
+
+struct record {
+    uint64_t key;
+    unsigned char payload[RECORD_SIZE-sizeof(uint64_t)];
+};
+
+#include "record_sort.h"
+
+// Hypercube quicksort of whole records, generated from hypercube_sort.h:
+// 	hypercube_sort_record(&list, &list_size, &list_capacity, &work,
+//			      &work_capacity, num_threads, comm)
+//
+#define SORT_NAME		record
+#define SORT_KEY		struct record
+#define SORT_ORDER_KEY(e)	((e).key)
+#define SORT_KEY_BYTES		8
+#include "hypercube_sort.h"
+
+// Routines --------------------------------------------------------------------
+//
+// Payload byte j of a record is derived from its key, so that check_records
+// can tell whether each payload still belongs to its key
+#define PAYLOAD_BYTE(key, j)	((unsigned char) (((key) >> (8*((j) % 8))) + (j)))
+
+// Allocate and initialize local records
+// Input:
+//   list_size 	- number of records
+//   type 	- initialization type (keys in increasing order,
+//  		  decreasing order, random)
+//   my_id	- process rank
+//   num_procs	- number of MPI processes
+// Output:
+//   list	- array of list_size records
+//
+struct record * initialize_records(int list_size, int type, int my_id, int num_procs) {
+    int j, b;
+    struct record * list = (struct record *) malloc(list_size*sizeof(struct record));
+    if (type >= 0) srand48(type + my_id);
+    for (j = 0; j < list_size; j++) {
+	switch (type) {
+	    case -1:	// Keys are in descending order
+		list[j].key = (uint64_t) (num_procs-my_id)*list_size-j;
+		break;
+	    case -2:	// Keys are in ascending order
+		list[j].key = (uint64_t) my_id*list_size+j+1;
+		break;
+	    default:
+		list[j].key = ((uint64_t) lrand48() << 33) ^ ((uint64_t) lrand48() << 16) ^ lrand48();
+		break;
+	}
+	for (b = 0; b < RECORD_SIZE-8; b++) {
+	    list[j].payload[b] = PAYLOAD_BYTE(list[j].key, b);
+	}
+    }
+    return list;
+}
+
+// Check if records are sorted by key across processes, every payload
+// still matches its key, no record was lost or duplicated (expected total
+// number of records), and the keys are a permutation of the initial keys
+// (key checksum, list_checksum.h); prints a message on process 0 if not
+// Input:
+//   list, list_size	- local records and their number
+//   expected_total	- number of records of all processes before sorting
+//   checksum		- key checksum of the records before sorting
+//   my_id, num_procs	- rank and number of MPI processes
+//
+void check_records(struct record *list, int list_size, long long expected_total,
+	struct list_checksum *checksum, int my_id, int num_procs) {
+    struct list_checksum final_checksum;
+    uint64_t max_nbr = 0, my_max;
+    long long count = list_size, total;
+    int error, local_error = 0;
+    int j, b;
+    if (my_id-1 >= 0) {
+	MPI_Recv(&max_nbr, 1, MPI_UINT64_T, my_id-1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+    for (j = 0; j < list_size; j++) {
+	if (list[j].key < ((j > 0) ? list[j-1].key : max_nbr)) local_error = 1;
+	for (b = 0; b < RECORD_SIZE-8; b++) {
+	    if (list[j].payload[b] != PAYLOAD_BYTE(list[j].key, b)) local_error = 1;
+	}
+    }
+    my_max = (list_size > 0) ? list[list_size-1].key : max_nbr;
+    if (my_id+1 < num_procs) {
+	MPI_Send(&my_max, 1, MPI_UINT64_T, my_id+1, 0, MPI_COMM_WORLD);
+    }
+    MPI_Reduce(&local_error, &error, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&count, &total, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    key_checksum((char *) list, list_size, sizeof(struct record), offsetof(struct record, key),
+	    &final_checksum, MPI_COMM_WORLD);
+    if (VERBOSE > 1) {
+	printf("[Proc: %0d] check_records: local_error = %d\n", my_id, local_error);
+    }
+    if (my_id == 0) {
+	if (error != 0) {
+	    printf("[Proc: %0d] Error encountered. The records have not been sorted correctly.\n", my_id);
+	}
+	if (total != expected_total) {
+	    printf("[Proc: %0d] Error encountered. %lld records after sorting, %lld expected.\n",
+		    my_id, total, expected_total);
+	}
+	if (!list_checksum_equal(checksum, &final_checksum)) {
+	    printf("[Proc: %0d] Error encountered. The keys are not a permutation of the initial keys.\n", my_id);
+	}
+	if (VERBOSE > 0) {
+	    printf("[Proc: %0d] check_records: total number of records = %lld\n", my_id, total);
+	}
+    }
+}
+
+//------------------------------------------------------------------------------
+// Main program
+//
+int main(int argc, char *argv[])
+{
+    // Local Variables ++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+    struct record *list;	// Local records
+    struct record *work = NULL;	// Work buffer for sorting whole records
+    int list_size;		// Number of local records
+    int list_size0;		// Number of initial local records (before sorting)
+    int list_capacity, work_capacity = 0;
+    int type;			// Method for initializing local records
+    int method;			// 0: tag sort, 1: whole records
+    int num_threads;		// Number of threads used for local sort
+    int error;
+    struct list_checksum checksum;	// Key checksum of records before sorting
+
+    // MPI variables
+    int num_procs; 		// Number of MPI processes
+    int my_id;			// Rank/id of this process
+    int provided;		// Thread support level provided by MPI
+
+    // Timing variables
+    double total_time;
+
+    MPI_Init_thread(&argc,&argv,MPI_THREAD_FUNNELED,&provided);	// Initialize MPI
+    MPI_Comm_size(MPI_COMM_WORLD,&num_procs);	// num_procs = number of MPI processes
+    MPI_Comm_rank(MPI_COMM_WORLD,&my_id);	// my_id = rank of this process
+
+    //  Check inputs
+    if ((argc != 4) && (argc != 5))  {
+	if (my_id == 0)
+	    printf("Usage: mpirun -np <number_of_processes> <executable_name> <list_size_per_process> <type> <method> [<threads_per_process>]\n");
+	exit(0);
+    }
+    list_size = atoi(argv[1]);
+    list_size0 = list_size;		// Save initial list size for reporting at the end
+    if ((list_size <= 0) || (list_size > MAX_LIST_SIZE_PER_PROC)) {
+	if (my_id == 0)
+	    printf("List size outside range [%d ... %d]. Aborting ...\n", 1, MAX_LIST_SIZE_PER_PROC);
+	exit(0);
+    };
+    type = atoi(argv[2]);
+    method = atoi(argv[3]);
+    num_threads = (argc == 5) ? atoi(argv[4]) : 1;
+    // Threads of the local sort need MPI_THREAD_FUNNELED; without it, sort
+    // with the calling thread only
+    if ((provided < MPI_THREAD_FUNNELED) && (num_threads > 1)) {
+	if (my_id == 0)
+	    printf("MPI does not provide MPI_THREAD_FUNNELED; using 1 thread per process\n");
+	num_threads = 1;
+    }
+
+    // Number of processes must be a power of 2 (2^dim = num_procs)
+    if ((num_procs & (num_procs-1)) != 0) {
+	if (my_id == 0)
+	    printf("Number of processors must be power of 2. Aborting ...\n");
+	exit(0);
+    }
+
+    // Initialize local records
+    list = initialize_records(list_size, type, my_id, num_procs);
+    list_capacity = list_size;
+    key_checksum((char *) list, list_size, sizeof(struct record), offsetof(struct record, key),
+	    &checksum, MPI_COMM_WORLD);
+
+    // Start Sort .............................................................
+    timing_begin("record sort");
+
+    if (method == 0) {
+	error = sort_records((char **) &list, &list_size, sizeof(struct record),
+		offsetof(struct record, key), num_threads, MPI_COMM_WORLD);
+    } else {
+	error = hypercube_sort_record(&list, &list_size, &list_capacity, &work, &work_capacity,
+		num_threads, MPI_COMM_WORLD);
+    }
+
+    total_time = timing_end();
+    // End Sort .............................................................
+
+    if (my_id == 0) {
+	printf("[Proc: %0d] number of processes = %d, initial local list size = %d, record size = %d, method = %s, record sort time = %.9f\n",
+		my_id, num_procs, list_size0, (int) sizeof(struct record),
+		(method == 0) ? "tags" : "records", total_time);
+    }
+    if (VERBOSE > 0) {
+	printf("[Proc: %0d] final local list size = %d, error = %d\n", my_id, list_size, error);
+    }
+
+    // Check if records have been sorted correctly
+    check_records(list, list_size, (long long) list_size0*num_procs, &checksum, my_id, num_procs);
+
+    if (TIMING_REPORT && (my_id == 0)) timing_report(stdout);
+
+    free(list); free(work);
+    free_hypercube_sort_comms(MPI_COMM_WORLD);
+    MPI_Finalize();				// Finalize MPI
+}
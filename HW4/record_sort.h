@@ -0,0 +1,145 @@
+// -----------------------------------------------------------------
+// Header file with a distributed sort of fixed-size records by a 64-bit
+// key
+//
+// Only compact tags, (key, origin) pairs with origin = (rank << 32) |
+// local index, go through the hypercube quicksort (hypercube_sort.h).
+// Once the tags are sorted, every process knows which record belongs at
+// each of its positions, and the payloads move exactly once:
+//   1. requests  - each process sends every owner the local indices of
+//		    the records it needs from it (MPI_Alltoallv of ints)
+//   2. responses - each owner sends back those records in the order they
+//		    were requested (MPI_Alltoallv of records)
+// Sorting whole records instead moves every record in each of the log p
+// exchange rounds and merges record_size bytes per element.
+//
+// Contains following routines
+//
+//   sort_records(&records, &num_records, record_size, key_offset,
+//		  num_threads, comm)
+//	- sort the records of all processes in comm in ascending order of
+//	  the unsigned 64-bit key at byte offset key_offset of each record.
+//	  records is a malloc'ed buffer of num_records records; it is
+//	  replaced by a new buffer and num_records changes. Returns 0, or
+//	  1 (and does nothing) if the size of comm is not a power of 2
+//
+//   hypercube_sort_record_tag(...)
+//	- hypercube quicksort of tags, generated from hypercube_sort.h
+//
+#ifndef RECORD_SORT_H
+#define RECORD_SORT_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+
+struct record_tag {
+    uint64_t key;			// Sort key of the record
+    uint64_t origin;			// (rank << 32) | index of the record
+};
+
+#define SORT_NAME		record_tag
+#define SORT_KEY		struct record_tag
+#define SORT_ORDER_KEY(e)	((e).key)
+#define SORT_KEY_BYTES		8
+#include "hypercube_sort.h"
+
+int sort_records(char ** records, int * num_records, size_t record_size, size_t key_offset,
+	int num_threads, MPI_Comm comm) {
+    char * list = *records;		// Local records
+    int list_size = *num_records;	// Number of local records
+    struct record_tag * tags;		// Tags of local records, then sorted tags
+    struct record_tag * work = NULL;	// Work buffer of the tag sort
+    int tag_capacity, work_capacity = 0;
+    int * send_counts, * send_displs;	// Requests sent to each owner
+    int * recv_counts, * recv_displs;	// Requests received from each process
+    int * requests;			// Local indices requested from owners
+    int * served;			// Local indices requested by other processes
+    int * dest;				// dest[s] = position of record of request s
+    int * next;				// Next request slot for each owner
+    char * responses, * served_records, * sorted;
+    MPI_Datatype record_type;
+    int num_procs, my_id, num_served, owner, i, s;
+
+    MPI_Comm_size(comm, &num_procs);
+    MPI_Comm_rank(comm, &my_id);
+
+    // Sort tags; key is copied with memcpy, as it need not be aligned
+    tags = (struct record_tag *) malloc(list_size*sizeof(struct record_tag));
+    tag_capacity = list_size;
+    for (i = 0; i < list_size; i++) {
+	memcpy(&tags[i].key, &list[i*record_size+key_offset], sizeof(uint64_t));
+	tags[i].origin = ((uint64_t) my_id << 32) | (uint64_t) i;
+    }
+    if (hypercube_sort_record_tag(&tags, &list_size, &tag_capacity, &work, &work_capacity,
+		num_threads, comm) != 0) {
+	free(tags); free(work);
+	return 1;
+    }
+    free(work);
+
+    // Group requests by owner; dest remembers where each record goes
+    send_counts = (int *) calloc(num_procs, sizeof(int));
+    send_displs = (int *) malloc(num_procs*sizeof(int));
+    recv_counts = (int *) malloc(num_procs*sizeof(int));
+    recv_displs = (int *) malloc(num_procs*sizeof(int));
+    next = (int *) malloc(num_procs*sizeof(int));
+    for (i = 0; i < list_size; i++) {
+	send_counts[tags[i].origin >> 32]++;
+    }
+    send_displs[0] = 0;
+    for (owner = 1; owner < num_procs; owner++) {
+	send_displs[owner] = send_displs[owner-1]+send_counts[owner-1];
+    }
+    memcpy(next, send_displs, num_procs*sizeof(int));
+    requests = (int *) malloc(list_size*sizeof(int));
+    dest = (int *) malloc(list_size*sizeof(int));
+    for (i = 0; i < list_size; i++) {
+	s = next[tags[i].origin >> 32]++;
+	requests[s] = (int) (tags[i].origin & 0xffffffffu);
+	dest[s] = i;
+    }
+    free(tags);
+
+    // Send requests to owners
+    MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, comm);
+    recv_displs[0] = 0;
+    for (owner = 1; owner < num_procs; owner++) {
+	recv_displs[owner] = recv_displs[owner-1]+recv_counts[owner-1];
+    }
+    num_served = recv_displs[num_procs-1]+recv_counts[num_procs-1];
+    served = (int *) malloc(num_served*sizeof(int));
+    MPI_Alltoallv(requests, send_counts, send_displs, MPI_INT,
+	    served, recv_counts, recv_displs, MPI_INT, comm);
+    free(requests);
+
+    // Send requested records back in the order they were requested
+    served_records = (char *) malloc(num_served*record_size);
+    for (s = 0; s < num_served; s++) {
+	memcpy(&served_records[s*record_size], &list[served[s]*record_size], record_size);
+    }
+    free(served);
+    free(list);
+    MPI_Type_contiguous((int) record_size, MPI_BYTE, &record_type);
+    MPI_Type_commit(&record_type);
+    responses = (char *) malloc(list_size*record_size);
+    MPI_Alltoallv(served_records, recv_counts, recv_displs, record_type,
+	    responses, send_counts, send_displs, record_type, comm);
+    MPI_Type_free(&record_type);
+    free(served_records);
+
+    // Put records in sorted order
+    sorted = (char *) malloc(list_size*record_size);
+    for (s = 0; s < list_size; s++) {
+	memcpy(&sorted[dest[s]*record_size], &responses[s*record_size], record_size);
+    }
+    free(responses); free(dest); free(next);
+    free(send_counts); free(send_displs); free(recv_counts); free(recv_displs);
+
+    *records = sorted;
+    *num_records = list_size;
+    return 0;
+}
+
+#endif
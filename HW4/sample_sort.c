@@ -0,0 +1,214 @@
+// -----------------------------------------------------------------------------
+// Sample Sort to sort a list of integers distributed across processors
+// MPI-based implementation; works with any number of processes
+//
+// Each process sorts its local list and takes regular samples of it; the
+// samples of all processes are gathered and sorted, and p-1 of them are
+// chosen as splitters. Every process then splits its list at the
+// splitters, a single MPI_Alltoallv sends piece j to process j, and each
+// process merges the p sorted pieces it receives.
+//
+// Uses initialize_list/check_list from qsort_hypercube.h so that results
+// and timings can be compared with hypercube quicksort.
+//
+// Routines (see sample_sort.h for the others):
+//   main	- main program that implements sample sort
+//
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "mpi.h"
+#include "../common/timing.h"
+#include "sort_io.h"
+#include "qsort_hypercube.h"
+#include "sample_sort.h"
+
+#define MAX_LIST_SIZE_PER_PROC	268435456
+
+#ifndef VERBOSE
+#define VERBOSE 0			// Use VERBOSE to control output
+#endif
+
+// Local sort routines for int, generated from local_sort.h:
+// 	local_sort_int(list, scratch, list_size, num_threads)
+// sorts list[0 ... list_size-1] in ascending order
+//
+#define SORT_NAME		int
+#define SORT_KEY		int
+#define SORT_ORDER_KEY(e)	((uint64_t) ((uint32_t) (e) ^ 0x80000000u))
+#define SORT_KEY_BYTES		4
+#include "local_sort.h"
+
+//------------------------------------------------------------------------------
+// Main program
+//
+int main(int argc, char *argv[])
+{
+    // Local Variables ++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+    int *list;			// Local list
+    int list_size;		// Local list size
+    int list_size0;		// Size of initial local list (before sorting)
+    int type;			// Method for initializing local lists
+    int num_threads;		// Number of threads used for local sort
+    char * output_file;		// File for sorted list (optional)
+    struct list_checksum checksum;	// Checksum of list before sorting
+    int error;			// Result of verify_sorted_list
+    int * work;			// Local sort scratch, then received pieces
+
+    int * my_samples;		// Regular samples of local list
+    int * samples;		// Regular samples of all processes
+    int * splitters;		// num_procs-1 splitters
+    int * split;		// Piece j of local list starts at split[j]
+    int * send_counts, * send_displs;	// Pieces sent to each process
+    int * recv_counts, * recv_displs;	// Pieces received from each process
+    int j;
+
+    // MPI variables
+    int num_procs; 		// Number of MPI processes
+    int my_id;			// Rank/id of this process
+    int provided;		// Thread support level provided by MPI
+
+    // Timing variables
+    double total_time, write_time, verify_time;
+
+    // Sample Sort Algorithm +++++++++++++++++++++++++++++++++++++++++++++++++++
+
+    MPI_Init_thread(&argc,&argv,MPI_THREAD_FUNNELED,&provided);	// Initialize MPI
+    MPI_Comm_size(MPI_COMM_WORLD,&num_procs);	// num_procs = number of MPI processes
+    MPI_Comm_rank(MPI_COMM_WORLD,&my_id);	// my_id = rank of this process
+
+    //  Check inputs
+    if ((argc < 3) || (argc > 5))  {
+	if (my_id == 0)
+	    printf("Usage: mpirun -np <number_of_processes> <executable_name> <list_size_per_process> <type> [<threads_per_process> [<output_file>]]\n");
+	exit(0);
+    }
+    list_size = atoi(argv[1]);
+    list_size0 = list_size;		// Save initial list size for reporting at the end
+    if ((list_size <= 0) || (list_size > MAX_LIST_SIZE_PER_PROC)) {
+	if (my_id == 0)
+	    printf("List size outside range [%d ... %d]. Aborting ...\n", 1, MAX_LIST_SIZE_PER_PROC);
+	exit(0);
+    };
+    type = atoi(argv[2]);
+    num_threads = (argc >= 4) ? atoi(argv[3]) : 1;
+    // Threads of the local sort need MPI_THREAD_FUNNELED; without it, sort
+    // with the calling thread only
+    if ((provided < MPI_THREAD_FUNNELED) && (num_threads > 1)) {
+	if (my_id == 0)
+	    printf("MPI does not provide MPI_THREAD_FUNNELED; using 1 thread per process\n");
+	num_threads = 1;
+    }
+    output_file = (argc == 5) ? argv[4] : NULL;
+
+    // Initialize local list
+    list = initialize_list(list_size, type, my_id, num_procs);
+    list_checksum(list, list_size, &checksum, MPI_COMM_WORLD);
+    work = (int *) malloc(list_size*sizeof(int));
+    my_samples = (int *) malloc(num_procs*sizeof(int));
+    samples = (int *) malloc(num_procs*num_procs*sizeof(int));
+    splitters = (int *) malloc(num_procs*sizeof(int));
+    split = (int *) malloc((num_procs+1)*sizeof(int));
+    send_counts = (int *) malloc(num_procs*sizeof(int));
+    send_displs = (int *) malloc(num_procs*sizeof(int));
+    recv_counts = (int *) malloc(num_procs*sizeof(int));
+    recv_displs = (int *) malloc((num_procs+1)*sizeof(int));
+
+    if (VERBOSE > 2) {
+	print_list(list, list_size, my_id, num_procs);
+    }
+
+    // Start Sample Sort ......................................................
+    timing_begin("sample sort");
+
+    // Sort local list
+    timing_begin("local sort");
+    local_sort_int(list, work, list_size, num_threads);
+    timing_end();
+
+    // Take num_procs regular samples of local list, at positions 
+    // j*list_size/num_procs; gather and sort samples of all processes. 
+    // Samples j*num_procs ... (j+1)*num_procs-1 then lie around the 
+    // j/num_procs quantile, and the middle one is splitter j
+    timing_begin("splitters and exchange");
+    for (j = 0; j < num_procs; j++) {
+	my_samples[j] = list[(j*(long long)list_size)/num_procs];
+    }
+    MPI_Allgather(my_samples, num_procs, MPI_INT, samples, num_procs, MPI_INT, MPI_COMM_WORLD);
+    introsort_int(samples, num_procs*num_procs);
+    for (j = 1; j < num_procs; j++) {
+	splitters[j-1] = samples[j*num_procs+num_procs/2];
+    }
+
+    // Split local list into one piece per process and exchange piece sizes
+    split_at_splitters(list, list_size, splitters, num_procs, split);
+    for (j = 0; j < num_procs; j++) {
+	send_counts[j] = split[j+1]-split[j];
+	send_displs[j] = split[j];
+    }
+    MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, MPI_COMM_WORLD);
+    recv_displs[0] = 0;
+    for (j = 0; j < num_procs; j++) {
+	recv_displs[j+1] = recv_displs[j]+recv_counts[j];
+    }
+
+    // Redistribute pieces; received pieces are sorted runs
+    if (recv_displs[num_procs] > list_size0) {
+	free(work);
+	work = (int *) malloc(recv_displs[num_procs]*sizeof(int));
+    }
+    MPI_Alltoallv(list, send_counts, send_displs, MPI_INT,
+	    work, recv_counts, recv_displs, MPI_INT, MPI_COMM_WORLD);
+
+    timing_end();
+
+    // Merge received runs into local list
+    timing_begin("merge");
+    list_size = recv_displs[num_procs];
+    if (list_size > list_size0) {
+	free(list);
+	list = (int *) malloc(list_size*sizeof(int));
+    }
+    merge_runs(work, recv_displs, num_procs, list);
+    timing_end();
+
+    total_time = timing_end();
+    // End Sample Sort ......................................................
+
+    if (my_id == 0) {
+	printf("[Proc: %0d] number of processes = %d, initial local list size = %d, sample sort time = %.9f\n", my_id, num_procs, list_size0, total_time);
+    }
+    if (VERBOSE > 0) {
+	printf("[Proc: %0d] final local list size = %d\n", my_id, list_size);
+    }
+
+    // Check if list has been sorted correctly
+    check_list(list, list_size, my_id, num_procs, &checksum);
+
+    if (VERBOSE > 2) {
+	print_list(list, list_size, my_id, num_procs);
+    }
+
+    // Write sorted list to output file and verify it in parallel
+    if (output_file != NULL) {
+	timing_begin("write");
+	write_sorted_list(list, list_size, output_file, MPI_COMM_WORLD);
+	write_time = timing_end();
+	timing_begin("verify");
+	error = verify_sorted_list(list, list_size, &checksum, 0, MPI_COMM_WORLD);
+	verify_time = timing_end();
+	if (my_id == 0) {
+	    printf("[Proc: %0d] output file = %s, write time = %f, verify time = %f\n", my_id, output_file, write_time, verify_time);
+	    if (error != 0) {
+		printf("[Proc: %0d] Error encountered. The output is %s.\n", my_id, 
+			(error == 1) ? "not sorted" : (error == 2) ? "not a permutation of the input" : "not sorted and not a permutation of the input");
+	    }
+	}
+    }
+
+    if (TIMING_REPORT && (my_id == 0)) timing_report(stdout);
+
+    free(list); free(work); free(my_samples); free(samples); free(splitters); free(split);
+    free(send_counts); free(send_displs); free(recv_counts); free(recv_displs);
+    MPI_Finalize();				// Finalize MPI
+}
@@ -0,0 +1,104 @@
+// -----------------------------------------------------------------
+// Header file with routines for sample sort (sample_sort.c and
+// external_sort.c):
+// - search a sorted list
+// - split a sorted list at splitters
+// - merge sorted runs
+//
+#include <stdlib.h>
+
+// Search for smallest element in a sorted list which is larger than value
+// (strict = 1) or larger than or equal to value (strict = 0)
+// Input:
+//   list, list_size	- list and its size
+//   value		- value to search for
+// Output:
+//   index of that element (list_size if there is none)
+//
+int bound_index(int *list, int list_size, int value, int strict) {
+    int first = 0, last = list_size, mid;
+    while (first < last) {
+	mid = first + (last-first)/2;
+	if ((list[mid] < value) || (strict && (list[mid] == value))) {
+	    first = mid+1;
+	} else {
+	    last = mid;
+	}
+    }
+    return last;
+}
+
+// Split sorted local list at the splitters
+// Piece j holds elements in (splitter[j-1], splitter[j]]. When several
+// consecutive splitters are equal, the elements equal to them are spread
+// evenly over the pieces they bound, so that heavily duplicated values
+// (e.g. type >= 0 inputs, values 0 ... 99) do not all go to one process.
+// Input:
+//   list, list_size	- sorted local list and its size
+//   splitters		- p-1 sorted splitters
+//   num_procs		- number of pieces p
+// Output:
+//   split		- piece j is list[split[j] ... split[j+1]-1];
+//			  split[0] = 0, split[p] = list_size
+//
+void split_at_splitters(int *list, int list_size, int *splitters, int num_procs, int *split) {
+    int j, g0, g1, lo, hi;
+    split[0] = 0;
+    split[num_procs] = list_size;
+    for (g0 = 0; g0 < num_procs-1; g0 = g1+1) {
+	// Group of equal splitters: splitters[g0 ... g1]
+	for (g1 = g0; (g1+1 < num_procs-1) && (splitters[g1+1] == splitters[g0]); g1++);
+	lo = bound_index(list, list_size, splitters[g0], 0);
+	hi = bound_index(list, list_size, splitters[g0], 1);
+	if (g1 == g0) {
+	    split[g0+1] = hi;
+	} else {
+	    for (j = g0; j <= g1; j++) {
+		split[j+1] = lo + (int) (((long long) (hi-lo)*(j-g0+1))/(g1-g0+2));
+	    }
+	}
+    }
+}
+
+// Merge sorted runs into one sorted list using a heap of run heads
+// Input:
+//   runs		- run r is runs[start[r] ... start[r+1]-1]
+//   start, num_runs	- run boundaries and number of runs
+// Output:
+//   list		- merged list of start[num_runs] elements
+//
+void merge_runs(int *runs, int *start, int num_runs, int *list) {
+    int * heap = (int *) malloc(num_runs*sizeof(int));	// run indices
+    int * pos = (int *) malloc(num_runs*sizeof(int));	// next element of run
+    int heap_size = 0;
+    int idx = 0;
+    int r, i, child;
+    for (r = 0; r < num_runs; r++) {
+	pos[r] = start[r];
+	if (pos[r] < start[r+1]) heap[heap_size++] = r;
+    }
+    // Build heap on run heads
+    for (i = heap_size/2-1; i >= 0; i--) {
+	r = heap[i];
+	while ((child = 2*i+1) < heap_size) {
+	    if ((child+1 < heap_size) && (runs[pos[heap[child+1]]] < runs[pos[heap[child]]])) child++;
+	    if (runs[pos[r]] <= runs[pos[heap[child]]]) break;
+	    heap[i] = heap[child]; i = child;
+	}
+	heap[i] = r;
+    }
+    // Repeatedly take smallest head, advance its run, restore heap
+    while (heap_size > 0) {
+	r = heap[0];
+	list[idx++] = runs[pos[r]++];
+	if (pos[r] == start[r+1]) r = heap[--heap_size];
+	i = 0;
+	while ((child = 2*i+1) < heap_size) {
+	    if ((child+1 < heap_size) && (runs[pos[heap[child+1]]] < runs[pos[heap[child]]])) child++;
+	    if (runs[pos[r]] <= runs[pos[heap[child]]]) break;
+	    heap[i] = heap[child]; i = child;
+	}
+	if (heap_size > 0) heap[i] = r;
+    }
+    free(heap); free(pos);
+}
@@ -0,0 +1,89 @@
+// -----------------------------------------------------------------
+// Header file with routines to:
+// - write a distributed sorted list to one binary file (MPI-IO)
+// - verify a distributed sorted list in O(log p) collective steps
+//
+// The file holds the elements of process 0, then those of process 1, and
+// so on, as native ints; the offset of each process is the exclusive
+// prefix sum (MPI_Exscan) of the list sizes, and all processes write
+// their lists at once with a collective MPI_File_write_at_all.
+//
+// The verifier checks order within each local list, and across processes
+// by comparing the first element of each list with the largest last
+// element of the lists of all lower ranks (an MPI_Exscan, instead of
+// passing it along a chain of processes). The checksum of the sorted
+// list (list_checksum.h) must equal the checksum of the list before the
+// sort, so elements cannot be dropped, duplicated or changed.
+//
+#include <limits.h>
+#include <stdio.h>
+#include "mpi.h"
+#include "list_checksum.h"
+
+// Write lists of all processes in comm, in rank order, to file path
+// Input:
+//   list, list_size	- local list and its size
+//   path		- output file; it is replaced if it exists
+//   comm		- communicator
+//
+void write_sorted_list(int *list, int list_size, const char *path, MPI_Comm comm) {
+    long long size = list_size, offset = 0, total;
+    int my_id;
+    MPI_File fh;
+    MPI_Comm_rank(comm, &my_id);
+    MPI_Exscan(&size, &offset, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    if (my_id == 0) offset = 0;			// Exscan leaves rank 0 undefined
+    MPI_Allreduce(&size, &total, 1, MPI_LONG_LONG, MPI_SUM, comm);
+
+    if (MPI_File_open(comm, path, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+	if (my_id == 0)
+	    printf("Cannot open output file %s. Aborting ...\n", path);
+	MPI_Abort(comm, 1);
+    }
+    MPI_File_set_size(fh, (MPI_Offset) (total*sizeof(int)));
+    MPI_File_write_at_all(fh, (MPI_Offset) (offset*sizeof(int)), list, list_size, MPI_INT,
+	    MPI_STATUS_IGNORE);
+    MPI_File_close(&fh);
+}
+
+// Verify that the lists of all processes in comm are sorted and are a
+// permutation of the lists before the sort
+// Input:
+//   list, list_size	- sorted local list and its size
+//   before		- checksum of the lists before the sort
+//			  (list_checksum over the same communicator)
+//   descending		- 1 if the list is sorted in descending order
+//   comm		- communicator
+// Output:
+//   0 if correct; otherwise bit 0 is set if the list is not sorted and
+//   bit 1 if it is not a permutation of the original list (same result
+//   on all processes)
+//
+int verify_sorted_list(int *list, int list_size, struct list_checksum *before, int descending,
+	MPI_Comm comm) {
+    long long last, prev;
+    int local_error = 0, error, my_id, j;
+    struct list_checksum after;
+    MPI_Comm_rank(comm, &my_id);
+
+    for (j = 1; j < list_size; j++) {
+	if (descending ? (list[j] > list[j-1]) : (list[j] < list[j-1])) local_error = 1;
+    }
+
+    // Largest (smallest if descending) last element on lower ranks; empty
+    // lists contribute a value that never wins
+    if (list_size > 0) {
+	last = list[list_size-1];
+    } else {
+	last = descending ? LLONG_MAX : LLONG_MIN;
+    }
+    MPI_Exscan(&last, &prev, 1, MPI_LONG_LONG, descending ? MPI_MIN : MPI_MAX, comm);
+    if ((my_id > 0) && (list_size > 0)) {
+	if (descending ? (list[0] > prev) : (list[0] < prev)) local_error = 1;
+    }
+
+    list_checksum(list, list_size, &after, comm);
+    MPI_Allreduce(&local_error, &error, 1, MPI_INT, MPI_MAX, comm);
+    if (!list_checksum_equal(before, &after)) error |= 2;
+    return error;
+}
@@ -0,0 +1,119 @@
+// ----------------------------------------------------------------------------
+// Minimum distance between n points on the CPU
+//
+// The CPU backend of nbody.cu without the CUDA code, so it can be built
+// and benchmarked on machines without nvcc: the points (generated as in
+// nbody.cu, or read from a point file) are searched on a uniform grid
+// (point_grid.h) with the given number of threads, for the given
+// precision policy (min_distance_cpu.h).
+//
+// Compilation command:
+//
+//   gcc -O3 -fopenmp-simd -fno-math-errno -march=native -o min_distance.exe min_distance.c -lpthread -lm
+//
+// Sample execution:
+//
+//   ./min_distance.exe 16777216 4
+//   ./min_distance.exe points.bin 4 2
+//
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "point_grid.h"
+#include "point_io.h"
+#include "../common/timing.h"
+
+#define MAX_POINTS 268435456
+
+// ----------------------------------------------------------------------------
+// Main program - initializes points and computes their minimum distance
+//
+int main(int argc, char * argv[]) {
+    float * X, * Y;			// Coordinates of the points
+    double * Xd = NULL, * Yd = NULL;	// Double coordinates (double policy)
+    struct point_file points;		// Mapped point file
+    struct timespec start, stop;
+    const char * precision_names[3] = {"float", "double", "refined"};
+    double min_distance, total_time, sqrtn;
+    int num_points, num_threads, precision, from_file, own_float = 1, own_double = 1, i;
+
+    if ((argc < 3) || (argc > 4)) {
+	printf("Use: %s <number of points | point file> <number of threads> [<precision 0 float|1 double|2 refined>]\n", argv[0]);
+	exit(0);
+    }
+    from_file = point_file_arg(argv[1]);
+    if (from_file) {
+	point_file_open(&points, argv[1]);
+	point_file_map(&points);
+	num_points = points.n;
+    } else {
+	num_points = atoi(argv[1]);
+    }
+    num_threads = atoi(argv[2]);
+    precision = (argc == 4) ? atoi(argv[3]) : PRECISION_FLOAT;
+    if ((num_points < 2) || (num_points > MAX_POINTS)) {
+	printf("Number of points outside range [%d ... %d]. Aborting ...\n", 2, MAX_POINTS);
+	exit(0);
+    }
+    if ((num_threads < 1) || (num_threads > MAX_CPU_THREADS)) {
+	printf("Number of threads outside range [%d ... %d]. Aborting ...\n", 1, MAX_CPU_THREADS);
+	exit(0);
+    }
+    if ((precision < PRECISION_FLOAT) || (precision > PRECISION_REFINED)) {
+	printf("Precision must be 0 (float), 1 (double) or 2 (refined)\n");
+	exit(0);
+    }
+
+    // Initialize points as in nbody.cu
+    if (from_file) {
+	own_float = point_file_floats(&points, &X, &Y);
+	own_double = (precision == PRECISION_DOUBLE) ? point_file_doubles(&points, &Xd, &Yd) : 0;
+    } else {
+	X = (float *) malloc(num_points*sizeof(float));
+	Y = (float *) malloc(num_points*sizeof(float));
+	srand48(0);
+	if (precision == PRECISION_DOUBLE) {
+	    Xd = (double *) malloc(num_points*sizeof(double));
+	    Yd = (double *) malloc(num_points*sizeof(double));
+	    sqrtn = sqrt((double) num_points);
+	    for (i = 0; i < num_points; i++) {
+		Xd[i] = sqrtn * drand48();
+		Yd[i] = sqrtn * drand48();
+		X[i] = (float) Xd[i];
+		Y[i] = (float) Yd[i];
+	    }
+	} else {
+	    sqrtn = (float) sqrt(num_points);
+	    for (i = 0; i < num_points; i++) {
+		X[i] = (float) sqrtn * (float)drand48();
+		Y[i] = (float) sqrtn * (float)drand48();
+	    }
+	}
+    }
+
+    timing_read(&start);
+
+    if (precision == PRECISION_FLOAT) {
+	min_distance = minimum_distance_grid(X, Y, num_points, num_threads);
+    } else {
+	min_distance = minimum_distance_grid_refined(X, Y, Xd, Yd, num_points, num_threads);
+    }
+
+    timing_read(&stop);
+    total_time = timing_elapsed(&start, &stop);
+
+    printf("Number of points = %d, threads = %d, precision = %s, min. distance = %.*e, time (sec) = %.9f\n",
+	    num_points, num_threads, precision_names[precision],
+	    (precision == PRECISION_FLOAT) ? 6 : 15, min_distance, total_time);
+
+    if (own_float) {
+	free(X); free(Y);
+    }
+    if (own_double) {
+	free(Xd); free(Yd);
+    }
+    if (from_file) point_file_close(&points);
+}
@@ -0,0 +1,40 @@
+// ----------------------------------------------------------------------------
+// Header file with a multithreaded CPU backend for the minimum distance
+// between n points
+//
+// Instantiates the tiled computation of min_distance_tiled.h for three
+// precision policies: throughput (float), accuracy (double), and float
+// with double refinement of candidate minima, which gives the accuracy
+// of double evaluation for float points at about the cost of float.
+//
+// Contains following routines
+//
+//    minimum_distance_tiled_float(X, Y, n, num_threads)
+//    minimum_distance_tiled_double(X, Y, n, num_threads)
+//    minimum_distance_tiled_refined(X, Y, n, num_threads)
+//	- minimum distance with float, double or refined float policy
+//
+#ifndef MIN_DISTANCE_CPU_H
+#define MIN_DISTANCE_CPU_H
+
+// Precision policies
+#define PRECISION_FLOAT		0	// Float coordinates and distances
+#define PRECISION_DOUBLE	1	// Double coordinates and distances
+#define PRECISION_REFINED	2	// Float, candidate minima recomputed in double
+
+#define MD_NAME		float
+#define MD_REAL		float
+#define MD_REFINE	0
+#include "min_distance_tiled.h"
+
+#define MD_NAME		double
+#define MD_REAL		double
+#define MD_REFINE	0
+#include "min_distance_tiled.h"
+
+#define MD_NAME		refined
+#define MD_REAL		float
+#define MD_REFINE	1
+#include "min_distance_tiled.h"
+
+#endif
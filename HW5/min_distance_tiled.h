@@ -0,0 +1,258 @@
+// ----------------------------------------------------------------------------
+// Header file with a multithreaded, tiled minimum distance between n
+// points, for a given precision policy
+//
+// This header is a template, like HW4/hypercube_sort.h: define the
+// parameters below and include it once per policy to generate the
+// routine for that policy.
+//
+//   MD_NAME	- suffix of generated routines (e.g. float)
+//   MD_REAL	- type of the coordinates and of the SIMD distance loops
+//		  (float or double)
+//   MD_REFINE	- 1 to recompute candidate minima in double: the SIMD
+//		  loops run in MD_REAL (float), and every block of pairs
+//		  whose minimum may be the overall minimum (within
+//		  REFINE_TOLERANCE) is recomputed in double. The result is
+//		  the minimum distance of the points evaluated in double,
+//		  at about the cost of the float loops. 0 otherwise
+//
+// Generated routine:
+//
+//   minimum_distance_tiled_<MD_NAME>(X, Y, n, num_threads)
+//	- minimum distance between n points, computed with num_threads
+//	  threads (returned as a double)
+//
+// The points are split into tiles of CPU_TILE_SIZE points; the x- and
+// y-coordinates of two tiles fit in L1 cache. Every pair of tiles (bi, bj)
+// with bi <= bj is a task, and threads take tasks from a shared counter,
+// so the triangular workload is balanced. For a task, CPU_TILE_ROWS points
+// of tile bi at a time are compared with the points of tile bj in a SIMD
+// loop, so each load of a point of tile bj serves CPU_TILE_ROWS points.
+// Only squared distances are compared; the square root is taken once, of
+// the minimum. The loops are min reductions, vectorized (AVX2 or AVX-512
+// lanes of floats or doubles, as the target allows) when compiled with
+// -O3 -fopenmp-simd -march=native, or -O3 -qopenmp-simd -xHost with icc.
+//
+// Parameters are undefined at the end of this header.
+//
+#ifndef MIN_DISTANCE_TILED_COMMON
+#define MIN_DISTANCE_TILED_COMMON
+
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#define CPU_TILE_SIZE	1024		// Points per tile
+#define CPU_TILE_ROWS	4		// Points of tile bi per pass over tile bj
+#define MAX_CPU_THREADS	1024		// Maximum no. of threads
+#define REFINE_TOLERANCE 1.0e-5		// Relative error bound of float squared distances
+
+#define MIN_DISTANCE_CAT2(a, b)	a##_##b
+#define MIN_DISTANCE_CAT(a, b)	MIN_DISTANCE_CAT2(a, b)
+
+struct min_distance_arg {
+    void * job;
+    int id;
+};
+
+// Tile pairs (bi, bj), bi <= bj, of num_tiles tiles: task k is tile pair
+// (tasks[2k], tasks[2k+1]). Diagonal tiles last: they have half the work
+// of the others. The number of tasks exceeds the int range from about
+// 65536 tiles (2^26 points), so it is counted in long long
+static int * min_distance_tile_tasks(int num_tiles, long long * num_tasks) {
+    int * tasks;
+    int bi, bj;
+    long long t = 0;
+    *num_tasks = (long long) num_tiles*(num_tiles+1)/2;
+    tasks = (int *) malloc(2*(size_t) (*num_tasks)*sizeof(int));
+    for (bi = 0; bi < num_tiles; bi++) {
+	for (bj = bi+1; bj < num_tiles; bj++) {
+	    tasks[2*t] = bi; tasks[2*t+1] = bj; t++;
+	}
+    }
+    for (bi = 0; bi < num_tiles; bi++) {
+	tasks[2*t] = bi; tasks[2*t+1] = bi; t++;
+    }
+    return tasks;
+}
+
+// Run fn on num_threads threads for job; calling thread works as thread 0
+static void min_distance_run_threads(void *(*fn)(void *), void * job, int num_threads) {
+    struct min_distance_arg args[MAX_CPU_THREADS];
+    pthread_t threads[MAX_CPU_THREADS];
+    int t;
+    for (t = 0; t < num_threads; t++) {
+	args[t].job = job;
+	args[t].id = t;
+    }
+    for (t = 1; t < num_threads; t++) {
+	pthread_create(&threads[t], NULL, fn, (void *) &args[t]);
+    }
+    fn((void *) &args[0]);
+    for (t = 1; t < num_threads; t++) {
+	pthread_join(threads[t], NULL);
+    }
+}
+
+#endif
+
+#define MD_FN(f)	MIN_DISTANCE_CAT(f, MD_NAME)
+
+struct MD_FN(min_distance_job) {
+    const MD_REAL * X, * Y;		// Coordinates of the points
+    int n;				// Number of points
+    int * tasks;			// Task k is tile pair (tasks[2k], tasks[2k+1])
+    long long num_tasks;
+    long long next_task;		// Next task to take; taken atomically
+    double result[MAX_CPU_THREADS];	// Minimum squared distance found by each thread
+};
+
+// ----------------------------------------------------------------------------
+// Minimum squared distance between point (xi, yi) and points first ... last-1
+static inline MD_REAL MD_FN(point_tile_min_distance2)(MD_REAL xi, MD_REAL yi,
+	const MD_REAL * __restrict__ X, const MD_REAL * __restrict__ Y, int first, int last) {
+    MD_REAL min_distance2 = (MD_REAL) FLT_MAX;
+    MD_REAL dx, dy, D2ij;
+    int j;
+#pragma omp simd reduction(min:min_distance2) private(dx, dy, D2ij)
+    for (j = first; j < last; j++) {
+	dx = X[j]-xi;
+	dy = Y[j]-yi;
+	D2ij = dx*dx+dy*dy;
+	min_distance2 = (D2ij < min_distance2) ? D2ij : min_distance2;
+    }
+    return min_distance2;
+}
+
+// Minimum squared distance between points i ... i+CPU_TILE_ROWS-1 and
+// points first ... last-1
+static inline MD_REAL MD_FN(rows_tile_min_distance2)(const MD_REAL * __restrict__ X,
+	const MD_REAL * __restrict__ Y, int i, int first, int last) {
+    MD_REAL x0 = X[i], x1 = X[i+1], x2 = X[i+2], x3 = X[i+3];
+    MD_REAL y0 = Y[i], y1 = Y[i+1], y2 = Y[i+2], y3 = Y[i+3];
+    MD_REAL m0 = (MD_REAL) FLT_MAX, m1 = m0, m2 = m0, m3 = m0;
+    MD_REAL dx, dy, D2ij;
+    int j;
+#pragma omp simd reduction(min:m0, m1, m2, m3) private(dx, dy, D2ij)
+    for (j = first; j < last; j++) {
+	dx = X[j]-x0; dy = Y[j]-y0; D2ij = dx*dx+dy*dy;
+	m0 = (D2ij < m0) ? D2ij : m0;
+	dx = X[j]-x1; dy = Y[j]-y1; D2ij = dx*dx+dy*dy;
+	m1 = (D2ij < m1) ? D2ij : m1;
+	dx = X[j]-x2; dy = Y[j]-y2; D2ij = dx*dx+dy*dy;
+	m2 = (D2ij < m2) ? D2ij : m2;
+	dx = X[j]-x3; dy = Y[j]-y3; D2ij = dx*dx+dy*dy;
+	m3 = (D2ij < m3) ? D2ij : m3;
+    }
+    m0 = (m1 < m0) ? m1 : m0;
+    m2 = (m3 < m2) ? m3 : m2;
+    return (m2 < m0) ? m2 : m0;
+}
+
+#if MD_REFINE
+// Minimum squared distance, in double, between points i_first ...
+// i_last-1 and points j_first ... j_last-1
+static double MD_FN(block_min_distance2_double)(const MD_REAL * X, const MD_REAL * Y,
+	int i_first, int i_last, int j_first, int j_last) {
+    double min_distance2 = DBL_MAX, dx, dy, D2ij;
+    int i, j;
+    for (i = i_first; i < i_last; i++) {
+	for (j = j_first; j < j_last; j++) {
+	    dx = (double) X[j]-(double) X[i];
+	    dy = (double) Y[j]-(double) Y[i];
+	    D2ij = dx*dx+dy*dy;
+	    if (D2ij < min_distance2) min_distance2 = D2ij;
+	}
+    }
+    return min_distance2;
+}
+
+// Block minimum D2ij (in MD_REAL) may be the overall minimum: recompute
+// block in double
+#define MD_CANDIDATE(D2ij, min_distance2) \
+    ((double) (D2ij) <= (min_distance2)*(1.0+REFINE_TOLERANCE))
+#endif
+
+// Thread function: take tile pairs until none are left
+static void *MD_FN(min_distance_thread)(void *s) {
+    struct min_distance_arg *arg = (struct min_distance_arg *) s;
+    struct MD_FN(min_distance_job) *job = (struct MD_FN(min_distance_job) *) arg->job;
+    double min_distance2 = DBL_MAX;
+    MD_REAL D2ij;
+    long long k;
+    int bi, bj, i, i_last, j_first, j_last;
+    while ((k = __atomic_fetch_add(&job->next_task, 1, __ATOMIC_RELAXED)) < job->num_tasks) {
+	bi = job->tasks[2*k];
+	bj = job->tasks[2*k+1];
+	i = bi*CPU_TILE_SIZE;
+	i_last = (bi+1)*CPU_TILE_SIZE < job->n ? (bi+1)*CPU_TILE_SIZE : job->n;
+	j_last = (bj+1)*CPU_TILE_SIZE < job->n ? (bj+1)*CPU_TILE_SIZE : job->n;
+	if (bi != bj) {
+	    for (; i+CPU_TILE_ROWS <= i_last; i += CPU_TILE_ROWS) {
+		D2ij = MD_FN(rows_tile_min_distance2)(job->X, job->Y, i, bj*CPU_TILE_SIZE, j_last);
+#if MD_REFINE
+		if (MD_CANDIDATE(D2ij, min_distance2)) {
+		    min_distance2 = fmin(min_distance2, MD_FN(block_min_distance2_double)(job->X,
+				job->Y, i, i+CPU_TILE_ROWS, bj*CPU_TILE_SIZE, j_last));
+		}
+#else
+		if (D2ij < min_distance2) min_distance2 = D2ij;
+#endif
+	    }
+	}
+	for (; i < i_last; i++) {
+	    // Within a tile, compare only with the points after point i
+	    j_first = (bi == bj) ? i+1 : bj*CPU_TILE_SIZE;
+	    D2ij = MD_FN(point_tile_min_distance2)(job->X[i], job->Y[i], job->X, job->Y, j_first, j_last);
+#if MD_REFINE
+	    if (MD_CANDIDATE(D2ij, min_distance2)) {
+		min_distance2 = fmin(min_distance2, MD_FN(block_min_distance2_double)(job->X,
+			    job->Y, i, i+1, j_first, j_last));
+	    }
+#else
+	    if (D2ij < min_distance2) min_distance2 = D2ij;
+#endif
+	}
+    }
+    job->result[arg->id] = min_distance2;
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+// Compute minimum distance between points with num_threads threads
+// Input:
+//	X: X[i] = x-coordinate of the ith point
+//	Y: Y[i] = y-coordinate of the ith point
+//	n: number of points
+//	num_threads: number of threads
+// Output:
+//	minimum distance
+//
+double MD_FN(minimum_distance_tiled)(const MD_REAL * X, const MD_REAL * Y, int n,
+	int num_threads) {
+    struct MD_FN(min_distance_job) job;
+    double min_distance2 = DBL_MAX;
+    int t;
+
+    if (num_threads < 1) num_threads = 1;
+    if (num_threads > MAX_CPU_THREADS) num_threads = MAX_CPU_THREADS;
+
+    job.X = X; job.Y = Y; job.n = n;
+    job.tasks = min_distance_tile_tasks((n+CPU_TILE_SIZE-1)/CPU_TILE_SIZE, &job.num_tasks);
+    job.next_task = 0;
+    min_distance_run_threads(MD_FN(min_distance_thread), (void *) &job, num_threads);
+    for (t = 0; t < num_threads; t++) {
+	if (job.result[t] < min_distance2) min_distance2 = job.result[t];
+    }
+    free(job.tasks);
+    return sqrt(min_distance2);
+}
+
+#ifdef MD_CANDIDATE
+#undef MD_CANDIDATE
+#endif
+#undef MD_FN
+#undef MD_NAME
+#undef MD_REAL
+#undef MD_REFINE
@@ -1,6 +1,30 @@
 // ---------------------------------------------------------------------------- 
 // CUDA code to compute minimun distance between n points
 //
+// Without a GPU device, or with more than MAX_GPU_POINTS points, the
+// minimum distance is computed by the multithreaded CPU backend, a
+// closest-pair search on a uniform grid of the points (point_grid.h).
+// The brute-force check on the host is done for up to MAX_CHECK_POINTS
+// points.
+//
+// A precision policy is chosen per run (min_distance_cpu.h):
+//   0 - float: float points and distances (GPU or CPU backend)
+//   1 - double: points generated in double; the CPU backend searches the
+//	 float-rounded points and recomputes candidate pairs in double
+//   2 - refined: float points; the CPU backend recomputes candidate
+//	 pairs in double, so the result is not affected by float rounding
+//	 of the distances
+// The check uses the tiled computation (min_distance_tiled.h) with the
+// same policy.
+//
+// The points are either generated (uniform in a sqrt(n) x sqrt(n) square)
+// or read from a point file (point_io.h, e.g. made by point_file.exe),
+// which is mapped and used in place.
+//
+// Compilation command (host code vectorized for the CPU backend):
+//
+//   nvcc -O3 -Xcompiler "-fopenmp-simd -fno-math-errno -march=native" -o nbody.exe nbody.cu -lpthread
+//
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
@@ -8,120 +32,89 @@
 #include <time.h>
 #include <limits>
 #include <float.h>
-
-#define MAX_POINTS 1048576
+#include <unistd.h>
+#include "point_grid.h"
+#include "reduction.h"
+#include "point_io.h"
+#include "../common/timing.h"
+
+#define MAX_POINTS 268435456
+#define MAX_GPU_POINTS 1048576
+#define MAX_CHECK_POINTS 32768
 #define block_size 1024
 
 
 // ---------------------------------------------------------------------------- 
 // Kernel Function to compute distance between all pairs of points
+//
+// Thread idx compares point idx with the points after it. The points are
+// read in tiles of block_size points, which the threads of a block load
+// together into shared memory, so each point is read from global memory
+// once per block rather than once per thread. Squared distances are
+// compared; the host takes the square root of the minimum.
+//
+// The minima of the threads are reduced per block by a tree with
+// sequential addressing, and thread 0 of each block combines the block
+// minimum into D[0] with a lock-free compare-and-swap (reduction.h).
+// D[0] must be set to REDUCTION_MIN_IDENTITY before each launch.
+//
 // Input: 
 //	X: X[i] = x-coordinate of the ith point
 //	Y: Y[i] = y-coordinate of the ith point
 //	n: number of points
 // Output: 
-//	D: D[0] = minimum distance
+//	D: D[0] = minimum squared distance
 //
-__device__ unsigned int finished_blocks = 0; 
-
-__global__ void minimum_distance_kernel(float * X, float * Y, volatile float * D, int n) {
+__global__ void minimum_distance_kernel(float * X, float * Y, float * D, int n) {
     unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x;
 
-    int i, z;
-    float dx, dy, temp_distance;    
+    int z, tile, z_first, z_last;
+    float dx, dy, temp_distance, xi, yi;    
     float minDist = FLT_MAX; 
     
-    bool finalBlockCheck;
-    
     __shared__ float local_minimums[block_size];
+    __shared__ float tile_X[block_size];
+    __shared__ float tile_Y[block_size];
 
-    if(idx < n - 1) {
-        for(z = idx + 1; z<n; z++) {   
-            dx = X[z] - X[idx];
-            dy = Y[z] - Y[idx];
-
-            temp_distance = sqrtf(dx * dx + dy * dy);   
+    xi = (idx < n) ? X[idx] : 0.0f;
+    yi = (idx < n) ? Y[idx] : 0.0f;
 
-            if(temp_distance < minDist) {
-                minDist = temp_distance;
-            }
-        }
-        local_minimums[threadIdx.x] = minDist;
+    // Tiles from the block's own tile on; all threads load and synchronize
+    for(tile = blockIdx.x * block_size; tile < n; tile += block_size) {
+        z = tile + threadIdx.x;
+        tile_X[threadIdx.x] = (z < n) ? X[z] : 0.0f;
+        tile_Y[threadIdx.x] = (z < n) ? Y[z] : 0.0f;
         __syncthreads();
-		
-        // Compute the block local minimum
-        int max_index = (n % block_size);
-		
-        if(max_index == 0) {
-            max_index = block_size;   
-        }
-        else {
-            if(blockIdx.x != n/block_size) {
-                max_index = block_size;    
-            }
-        }
-
-        for(i = 1; i<max_index; i *= 2) {
-            if(threadIdx.x % (2 * i) == 0 && (threadIdx.x + i) < max_index - 1) {
-                if(local_minimums[threadIdx.x] > local_minimums[threadIdx.x + i]) {
-                    local_minimums[threadIdx.x] = local_minimums[threadIdx.x + i];  
-                }
-                __syncthreads();
-            } 
-        }
 
-        if(threadIdx.x == 0) {
-            D[blockIdx.x] = local_minimums[0];
+        // In the block's own tile, only the points after point idx
+        z_first = (tile == blockIdx.x * block_size) ? threadIdx.x + 1 : 0;
+        z_last = (n - tile < block_size) ? n - tile : block_size;
+        if(idx < n - 1) {
+            for(z = z_first; z < z_last; z++) {   
+                dx = tile_X[z] - xi;
+                dy = tile_Y[z] - yi;
 
-            int value = atomicInc(&finished_blocks, gridDim.x);
-            finalBlockCheck = (value == (gridDim.x - 1));
-        }
-
-        // Last thread in the list computes the global minimum and puts it in D[0]
-        if(finalBlockCheck && threadIdx.x == 0) {
-            int blocks = n / block_size + (n % block_size != 0);
+                temp_distance = dx * dx + dy * dy;   
 
-            for(i = 1; i<blocks; i++) {
-                if(D[0] > D[i]) {
-                    D[0] = D[i];                   
+                if(temp_distance < minDist) {
+                    minDist = temp_distance;
                 }
             }
-        }            
-    }    
-}
+        }
+        __syncthreads();
+    }
 
+    // Threads without points keep FLT_MAX; all threads take part in the
+    // block reduction
+    local_minimums[threadIdx.x] = minDist;
+    minDist = reduce_min_block(local_minimums, block_size);
 
-// ---------------------------------------------------------------------------- 
-// Host function to compute minimum distance between points
-// Input:
-//	X: X[i] = x-coordinate of the ith point
-//	Y: Y[i] = y-coordinate of the ith point
-//	n: number of points
-// Output: 
-//	D: minimum distance
-//
-float minimum_distance_host(float * X, float * Y, int n) {
-    float dx, dy, Dij, min_distance, min_distance_i;
-    int i, j;
-    dx = X[1]-X[0];
-    dy = Y[1]-Y[0];
-    min_distance = sqrtf(dx*dx+dy*dy);
-    for (i = 0; i < n-1; i++) {
-	for (j = i+1; j < i+2; j++) {
-	    dx = X[j]-X[i];
-	    dy = Y[j]-Y[i];
-	    min_distance_i = sqrtf(dx*dx+dy*dy);
-	}
-	for (j = i+1; j < n; j++) {
-	    dx = X[j]-X[i];
-	    dy = Y[j]-Y[i];
-	    Dij = sqrtf(dx*dx+dy*dy);
-	    if (min_distance_i > Dij) min_distance_i = Dij;
-	}
-	if (min_distance > min_distance_i) min_distance = min_distance_i;
+    if(threadIdx.x == 0) {
+        reduce_min_combine(D, minDist);
     }
-    return min_distance;
 }
+
+
 // ---------------------------------------------------------------------------- 
 // Print device properties
 void print_device_properties() {
@@ -154,12 +147,12 @@ int main(int argc, char* argv[]) {
     // Host Data
     float * hVx;		// host x-coordinate array
     float * hVy;		// host y-coordinate array
-    float hmin_dist;		// minimum value on host
+    float hmin_dist;		// minimum squared distance on host
 
     // Device Data
     float * dVx;		// device x-coordinate array
     float * dVy;		// device x-coordinate array
-    float * dmin_dist;		// minimum value on device
+    float * dmin_dist;		// minimum squared distance on device
 
     // Device parameters
     //int MAX_BLOCK_SIZE;		// Maximum number of threads allowed on the device
@@ -173,7 +166,16 @@ int main(int argc, char* argv[]) {
 
     // Other variables
     int i, size, num_points; 
-    float min_distance, sqrtn;
+    int num_threads;		// Number of threads of CPU backend
+    int use_gpu;		// 1 if minimum distance is computed on GPU
+    int precision;		// Precision policy
+    double * hVxd, * hVyd;	// Double coordinates (double policy)
+    double backend_distance;	// Minimum distance from GPU or CPU backend
+    double min_distance, sqrtn;
+    const char * precision_names[3] = {"float", "double", "refined"};
+    struct point_file points;	// Mapped point file
+    int from_file;		// 1 if points are read from a point file
+    int own_float, own_double;	// 1 if coordinate arrays were allocated
     int seed = 0;
 
     // Print device properties
@@ -188,101 +190,192 @@ int main(int argc, char* argv[]) {
 	cudaGetDeviceProperties(&deviceProp, 0);
 	//int MAX_BLOCK_SIZE = deviceProp.maxThreadsPerBlock;
     } else {
-	printf("Warning: No GPU device found ... results may be incorrect\n");
+	printf("No GPU device found ... using multithreaded CPU backend\n");
     }
 
-    // Timing initializations
-    cudaEventCreate(&start);
-    cudaEventCreate(&stop);
-
     // Check input
-    if (argc != 2) {
-	printf("Use: %s <number of points>\n", argv[0]);  
+    if ((argc < 2) || (argc > 4)) {
+	printf("Use: %s <number of points | point file> [<number of CPU threads> [<precision 0 float|1 double|2 refined>]]\n", argv[0]);  
 	exit(0);
     }
-    if ((num_points = atoi(argv[argc-1])) < 2) {
+    from_file = point_file_arg(argv[1]);
+    if (from_file) {
+	point_file_open(&points, argv[1]);
+	point_file_map(&points);
+	num_points = points.n;
+    } else {
+	num_points = atoi(argv[1]);
+    }
+    if (num_points < 2) {
 	printf("Minimum number of points allowed: 2\n");
 	exit(0);
     } 
-    if ((num_points = atoi(argv[argc-1])) > MAX_POINTS) {
+    if (num_points > MAX_POINTS) {
 	printf("Maximum number of points allowed: %d\n", MAX_POINTS);
 	exit(0);
     } 
+    num_threads = (argc >= 3) ? atoi(argv[2]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_threads < 1) num_threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    precision = (argc == 4) ? atoi(argv[3]) : PRECISION_FLOAT;
+    if ((precision < PRECISION_FLOAT) || (precision > PRECISION_REFINED)) {
+	printf("Precision must be 0 (float), 1 (double) or 2 (refined)\n");
+	exit(0);
+    }
+    use_gpu = (deviceCount > 0) && (num_points <= MAX_GPU_POINTS) && (precision == PRECISION_FLOAT);
+    if ((deviceCount > 0) && (num_points > MAX_GPU_POINTS)) {
+	printf("More than %d points ... using multithreaded CPU backend\n", MAX_GPU_POINTS);
+    } else if ((deviceCount > 0) && !use_gpu) {
+	printf("Precision %s ... using multithreaded CPU backend\n", precision_names[precision]);
+    }
 
     // Allocate host coordinate arrays 
     size = num_points * sizeof(float); 
-    hVx = (float *) malloc(size); 
-    hVy = (float *) malloc(size);
+    if (!from_file) {
+	hVx = (float *) malloc(size); 
+	hVy = (float *) malloc(size);
+    }
 
     // Initialize points
     srand48(seed);
-    sqrtn = (float) sqrt(num_points); 
-    for (i = 0; i < num_points; i++) {
-	hVx[i] = sqrtn * (float)drand48();
-	hVy[i] = sqrtn * (float)drand48();
+    hVxd = hVyd = NULL;
+    own_float = own_double = 1;
+    if (from_file) {
+	// Points of a mapped float file are used in place; other arrays
+	// are converted copies
+	own_float = point_file_floats(&points, &hVx, &hVy);
+	own_double = (precision == PRECISION_DOUBLE) ? point_file_doubles(&points, &hVxd, &hVyd) : 0;
+    } else if (precision == PRECISION_DOUBLE) {
+	// Backend searches float-rounded points, refines with hVxd, hVyd
+	hVxd = (double *) malloc(num_points*sizeof(double));
+	hVyd = (double *) malloc(num_points*sizeof(double));
+	sqrtn = sqrt((double) num_points);
+	for (i = 0; i < num_points; i++) {
+	    hVxd[i] = sqrtn * drand48();
+	    hVyd[i] = sqrtn * drand48();
+	    hVx[i] = (float) hVxd[i];
+	    hVy[i] = (float) hVyd[i];
+	}
+    } else {
+	sqrtn = (float) sqrt(num_points); 
+	for (i = 0; i < num_points; i++) {
+	    hVx[i] = (float) sqrtn * (float)drand48();
+	    hVy[i] = (float) sqrtn * (float)drand48();
+	}
     }
 
-    // Allocate device coordinate arrays
-    cudaMalloc(&dVx, size);
-    cudaMalloc(&dVy, size);
-    cudaMalloc(&dmin_dist, size);
+    if (use_gpu) {
+	// Timing initializations
+	cudaEventCreate(&start);
+	cudaEventCreate(&stop);
 
-    // Copy coordinate arrays from host memory to device memory 
-    cudaEventRecord( start, 0 ); 
+	// Allocate device coordinate arrays
+	cudaMalloc(&dVx, size);
+	cudaMalloc(&dVy, size);
+	cudaMalloc(&dmin_dist, sizeof(float));
 
-    cudaMemcpy(dVx, hVx, size, cudaMemcpyHostToDevice);
-    cudaMemcpy(dVy, hVy, size, cudaMemcpyHostToDevice);
+	// Copy coordinate arrays from host memory to device memory 
+	cudaEventRecord( start, 0 ); 
 
-    cudaEventRecord(stop, 0);
-    cudaEventSynchronize(stop);
-    cudaEventElapsedTime(&(time_array[0]), start, stop);
+	cudaMemcpy(dVx, hVx, size, cudaMemcpyHostToDevice);
+	cudaMemcpy(dVy, hVy, size, cudaMemcpyHostToDevice);
 
-    // Invoke kernel
-    cudaEventRecord( start, 0 ); 
+	// Reset the result, so the kernel can be launched repeatedly
+	hmin_dist = REDUCTION_MIN_IDENTITY;
+	cudaMemcpy(dmin_dist, &hmin_dist, sizeof(float), cudaMemcpyHostToDevice);
 
-    blocks = num_points / block_size + (num_points % block_size != 0);
+	cudaEventRecord(stop, 0);
+	cudaEventSynchronize(stop);
+	cudaEventElapsedTime(&(time_array[0]), start, stop);
 
-    minimum_distance_kernel<<<blocks, block_size>>>(dVx, dVy, dmin_dist, num_points);
+	// Invoke kernel
+	cudaEventRecord( start, 0 ); 
 
-    cudaEventRecord(stop, 0);
-    cudaEventSynchronize(stop);
-    cudaEventElapsedTime(&(time_array[1]), start, stop);
+	blocks = num_points / block_size + (num_points % block_size != 0);
 
-    // Copy result from device memory to host memory 
-    cudaEventRecord( start, 0 ); 
+	minimum_distance_kernel<<<blocks, block_size>>>(dVx, dVy, dmin_dist, num_points);
 
-    cudaMemcpy(&hmin_dist, dmin_dist, sizeof(float), cudaMemcpyDeviceToHost);
+	cudaEventRecord(stop, 0);
+	cudaEventSynchronize(stop);
+	cudaEventElapsedTime(&(time_array[1]), start, stop);
 
-    cudaEventRecord(stop, 0);
-    cudaEventSynchronize(stop);
-    cudaEventElapsedTime(&(time_array[2]), start, stop);
+	// Copy result from device memory to host memory 
+	cudaEventRecord( start, 0 ); 
 
-    // Compute minimum distance on host to check device computation
-    clock_gettime(CLOCK_REALTIME, &cpu_start);
+	cudaMemcpy(&hmin_dist, dmin_dist, sizeof(float), cudaMemcpyDeviceToHost);
 
-    min_distance = minimum_distance_host(hVx, hVy, num_points); 
+	cudaEventRecord(stop, 0);
+	cudaEventSynchronize(stop);
+	cudaEventElapsedTime(&(time_array[2]), start, stop);
+	backend_distance = sqrtf(hmin_dist);
+    } else {
+	// Compute minimum distance with CPU backend
+	timing_read(&cpu_start);
+
+	if (precision == PRECISION_FLOAT) {
+	    backend_distance = minimum_distance_grid(hVx, hVy, num_points, num_threads); 
+	} else {
+	    backend_distance = minimum_distance_grid_refined(hVx, hVy, hVxd, hVyd, num_points,
+		    num_threads);
+	}
+
+	timing_read(&cpu_stop);
+	time_array[1] = 1000*timing_elapsed(&cpu_start, &cpu_stop);
+    }
 
-    clock_gettime(CLOCK_REALTIME, &cpu_stop);
-    time_array[3] = 1000*((cpu_stop.tv_sec-cpu_start.tv_sec)                    
-	    +0.000000001*(cpu_stop.tv_nsec-cpu_start.tv_nsec));
+    // Compute minimum distance on host to check device computation
+    // (brute force: O(n^2), so only for small n)
+    if (num_points <= MAX_CHECK_POINTS) {
+	timing_read(&cpu_start);
+
+	if (precision == PRECISION_DOUBLE) {
+	    min_distance = minimum_distance_tiled_double(hVxd, hVyd, num_points, num_threads);
+	} else if (precision == PRECISION_REFINED) {
+	    min_distance = minimum_distance_tiled_refined(hVx, hVy, num_points, num_threads);
+	} else {
+	    min_distance = minimum_distance_tiled_float(hVx, hVy, num_points, num_threads);
+	}
+
+	timing_read(&cpu_stop);
+	time_array[3] = 1000*timing_elapsed(&cpu_start, &cpu_stop);
+    }
 
     // Print results
     printf("Number of Points    = %d\n", num_points); 
-    printf("GPU Host-to-device  = %f ms \n", time_array[0]);
-    printf("GPU Device-to-host  = %f ms \n", time_array[2]);
-    printf("GPU execution time  = %f ms \n", time_array[1]);
-    printf("CPU execution time  = %f ms\n", time_array[3]);
-    printf("Min. distance (GPU) = %e\n", hmin_dist);
-    printf("Min. distance (CPU) = %e\n", min_distance);
-    printf("Relative error      = %e\n", fabs(min_distance-hmin_dist)/min_distance);
+    printf("Precision           = %s\n", precision_names[precision]);
+    if (use_gpu) {
+	printf("GPU Host-to-device  = %f ms \n", time_array[0]);
+	printf("GPU Device-to-host  = %f ms \n", time_array[2]);
+	printf("GPU execution time  = %f ms \n", time_array[1]);
+    } else {
+	printf("CPU backend threads = %d\n", num_threads);
+	printf("CPU backend time    = %f ms \n", time_array[1]);
+    }
+    printf("Min. distance (%s) = %.*e\n", use_gpu ? "GPU" : "MT ",
+	    (precision == PRECISION_FLOAT) ? 6 : 15, backend_distance);
+    if (num_points <= MAX_CHECK_POINTS) {
+	printf("CPU execution time  = %f ms\n", time_array[3]);
+	printf("Min. distance (CPU) = %.*e\n", (precision == PRECISION_FLOAT) ? 6 : 15, min_distance);
+	printf("Relative error      = %e\n", fabs(min_distance-backend_distance)/min_distance);
+    } else {
+	printf("CPU check skipped for more than %d points\n", MAX_CHECK_POINTS);
+    }
 
 
     // Free device memory 
-    cudaFree(dVx);
-    cudaFree(dVy);
-    cudaFree(dmin_dist);
+    if (use_gpu) {
+	cudaFree(dVx);
+	cudaFree(dVy);
+	cudaFree(dmin_dist);
+    }
 
     // Free host memory 
-    free(hVx);
-    free(hVy);
+    if (own_float) {
+	free(hVx);
+	free(hVy);
+    }
+    if (own_double) {
+	free(hVxd);
+	free(hVyd);
+    }
+    if (from_file) point_file_close(&points);
 }  
@@ -0,0 +1,181 @@
+// ----------------------------------------------------------------------------
+// Create and inspect point files (point_io.h)
+//
+//   gen <n> <file> [double]	- n points as generated by nbody.cu (uniform
+//				  in a sqrt(n) x sqrt(n) square); float, or
+//				  double as for its double precision policy
+//   text <input> <file> [double] - points of a text file, one "x y" pair per
+//				  line; converted POINT_FILE_CHUNK points at a
+//				  time, so inputs larger than memory can be
+//				  converted
+//   info <file>		- header and bounding box of a point file,
+//				  read in chunks
+//
+// The files can be given to nbody.exe, point_queries.exe and
+// point_stream.exe in place of the number of points.
+//
+// Compilation command:
+//
+//   gcc -O3 -o point_file.exe point_file.c -lm
+//
+// Sample execution:
+//
+//   ./point_file.exe gen 1048576 points.bin
+//   ./nbody.exe points.bin
+//
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "point_io.h"
+
+#define MAX_POINTS 268435456
+
+// ----------------------------------------------------------------------------
+// Write n synthetic points, generated a chunk at a time
+void generate_points(const char * path, int n, int coord_size) {
+    struct point_file file;
+    float * X, * Y;
+    double * Xd, * Yd, sqrtn;
+    int first, count, i;
+    X = (float *) malloc(POINT_FILE_CHUNK*sizeof(float));
+    Y = (float *) malloc(POINT_FILE_CHUNK*sizeof(float));
+    Xd = (double *) malloc(POINT_FILE_CHUNK*sizeof(double));
+    Yd = (double *) malloc(POINT_FILE_CHUNK*sizeof(double));
+    point_file_create(&file, path, n, coord_size);
+    srand48(0);
+    for (first = 0; first < n; first += count) {
+	count = (n-first < POINT_FILE_CHUNK) ? n-first : POINT_FILE_CHUNK;
+	if (coord_size == sizeof(double)) {
+	    sqrtn = sqrt((double) n);
+	    for (i = 0; i < count; i++) {
+		Xd[i] = sqrtn * drand48();
+		Yd[i] = sqrtn * drand48();
+	    }
+	    point_file_write(&file, first, Xd, Yd, count);
+	} else {
+	    sqrtn = (float) sqrt(n);
+	    for (i = 0; i < count; i++) {
+		X[i] = (float) sqrtn * (float)drand48();
+		Y[i] = (float) sqrtn * (float)drand48();
+	    }
+	    point_file_write(&file, first, X, Y, count);
+	}
+    }
+    point_file_close(&file);
+    free(X); free(Y); free(Xd); free(Yd);
+}
+
+// Convert text file input ("x y" per line) to a point file: count the
+// points, then read and write them a chunk at a time; aborts if the input
+// is not a sequence of number pairs (e.g. an odd value at the end)
+void convert_text(const char * input, const char * path, int coord_size) {
+    struct point_file file;
+    FILE * fp;
+    double * X, * Y, x, y;
+    float * Xf, * Yf;
+    long long n = 0;
+    int first, count, i, read;
+
+    if ((fp = fopen(input, "r")) == NULL) {
+	printf("Cannot open text file %s. Aborting ...\n", input);
+	exit(1);
+    }
+    while ((read = fscanf(fp, "%lf %lf", &x, &y)) == 2) n++;
+    if (read != EOF) {
+	// Odd value at the end, or text that is not a number
+	printf("Malformed text file %s after %lld points. Aborting ...\n", input, n);
+	exit(1);
+    }
+    if ((n < 2) || (n > MAX_POINTS)) {
+	printf("Number of points in %s (%lld) outside range [%d ... %d]. Aborting ...\n",
+		input, n, 2, MAX_POINTS);
+	exit(1);
+    }
+    rewind(fp);
+
+    X = (double *) malloc(POINT_FILE_CHUNK*sizeof(double));
+    Y = (double *) malloc(POINT_FILE_CHUNK*sizeof(double));
+    Xf = (float *) malloc(POINT_FILE_CHUNK*sizeof(float));
+    Yf = (float *) malloc(POINT_FILE_CHUNK*sizeof(float));
+    point_file_create(&file, path, (int) n, coord_size);
+    for (first = 0; first < n; first += count) {
+	count = (n-first < POINT_FILE_CHUNK) ? (int) n-first : POINT_FILE_CHUNK;
+	for (i = 0; i < count; i++) {
+	    if (fscanf(fp, "%lf %lf", &X[i], &Y[i]) != 2) {
+		printf("Cannot read text file %s. Aborting ...\n", input);
+		exit(1);
+	    }
+	    Xf[i] = (float) X[i];
+	    Yf[i] = (float) Y[i];
+	}
+	if (coord_size == sizeof(double)) {
+	    point_file_write(&file, first, X, Y, count);
+	} else {
+	    point_file_write(&file, first, Xf, Yf, count);
+	}
+    }
+    point_file_close(&file);
+    fclose(fp);
+    free(X); free(Y); free(Xf); free(Yf);
+}
+
+// Print header and bounding box of a point file
+void print_info(const char * path) {
+    struct point_file file;
+    float * X, * Y;
+    float x_min = FLT_MAX, x_max = -FLT_MAX, y_min = FLT_MAX, y_max = -FLT_MAX;
+    int first, count, i;
+    point_file_open(&file, path);
+    X = (float *) malloc(POINT_FILE_CHUNK*sizeof(float));
+    Y = (float *) malloc(POINT_FILE_CHUNK*sizeof(float));
+    for (first = 0; first < file.n; first += count) {
+	count = (file.n-first < POINT_FILE_CHUNK) ? file.n-first : POINT_FILE_CHUNK;
+	point_file_read(&file, first, X, Y, count);
+	for (i = 0; i < count; i++) {
+	    if (X[i] < x_min) x_min = X[i];
+	    if (X[i] > x_max) x_max = X[i];
+	    if (Y[i] < y_min) y_min = Y[i];
+	    if (Y[i] > y_max) y_max = Y[i];
+	}
+    }
+    printf("File = %s, points = %d, coordinates = %s, x range = [%e, %e], y range = [%e, %e]\n",
+	    path, file.n, (file.header.coord_size == sizeof(double)) ? "double" : "float",
+	    x_min, x_max, y_min, y_max);
+    point_file_close(&file);
+    free(X); free(Y);
+}
+
+// ----------------------------------------------------------------------------
+// Main program - generates, converts or inspects a point file
+//
+int main(int argc, char * argv[]) {
+    int n, coord_size;
+    if ((argc >= 2) && (strcmp(argv[1], "info") == 0) && (argc == 3)) {
+	print_info(argv[2]);
+	return 0;
+    }
+    if ((argc < 4) || (argc > 5) || ((argc == 5) && (strcmp(argv[4], "double") != 0))) {
+	printf("Use: %s gen <number of points> <file> [double]\n", argv[0]);
+	printf("     %s text <input file> <file> [double]\n", argv[0]);
+	printf("     %s info <file>\n", argv[0]);
+	exit(0);
+    }
+    coord_size = (argc == 5) ? sizeof(double) : sizeof(float);
+    if (strcmp(argv[1], "gen") == 0) {
+	n = atoi(argv[2]);
+	if ((n < 2) || (n > MAX_POINTS)) {
+	    printf("Number of points outside range [%d ... %d]. Aborting ...\n", 2, MAX_POINTS);
+	    exit(0);
+	}
+	generate_points(argv[3], n, coord_size);
+    } else if (strcmp(argv[1], "text") == 0) {
+	convert_text(argv[2], argv[3], coord_size);
+    } else {
+	printf("Unknown command %s\n", argv[1]);
+	exit(0);
+    }
+    print_info(argv[3]);
+    return 0;
+}
@@ -0,0 +1,550 @@
+// ----------------------------------------------------------------------------
+// Header file with a uniform grid index of points in the plane and an
+// O(n) expected time closest-pair computation on it
+//
+// The bounding box of the points is split into square cells of side
+// cell_size, numbered row by row. The points are reordered by cell with
+// a parallel counting sort in two passes: threads count the points of
+// their chunk per row of cells and scatter them by row (few, sequentially
+// written buckets), then threads take rows and sort the points of a row
+// by cell, in cache. So the points of a cell, and of a run of cells in
+// the same row, are contiguous in the index.
+//
+// If the closest pair is at distance d <= cell_size, its points lie in
+// the same or adjacent cells. Each point is compared with the points
+// after it in its own cell and the next cell of its row (one contiguous
+// range), and with the three cells below it in the next row (another
+// contiguous range); only squared distances are compared. Threads
+// take rows of cells from a shared counter. If the minimum found is not
+// smaller than cell_size, the grid is rebuilt with larger cells; for
+// uniformly distributed points with POINTS_PER_CELL points per cell, this
+// never happens in practice.
+//
+// The distance loops over these ranges are scalar, for every precision
+// policy. A range holds about 4 (same row) or 6 (next row) points, too few
+// for the SIMD loops of min_distance_tiled.h: with its float kernel
+// (point_tile_min_distance2_float) in place of point_range_min_distance2,
+// the search took 15-17% longer (16M uniform points, one thread, float
+// and refined). The double and refined policies run the same float
+// search, then recompute in double only the few pairs within rounding
+// error of the float minimum. The SIMD templates are used by the
+// O(n^2) tiled computation, which checks the grid result for small n.
+//
+// Contains following routines
+//
+//    point_grid_build(&grid, X, Y, n, cell_size, num_threads)
+//	- build grid of n points; default cell size if cell_size <= 0
+//
+//    point_grid_free(&grid)
+//	- free grid arrays
+//
+//    point_grid_min_distance(&grid, num_threads)
+//	- minimum distance between points in the same or adjacent cells
+//
+//    minimum_distance_grid(X, Y, n, num_threads)
+//	- minimum distance between n points
+//
+//    minimum_distance_grid_refined(X, Y, Xd, Yd, n, num_threads)
+//	- minimum distance between n points, evaluated in double: the
+//	  grid search runs in float, then the pairs within rounding error
+//	  of the float minimum are recomputed in double (from Xd, Yd if
+//	  the points have double coordinates)
+//
+#ifndef POINT_GRID_H
+#define POINT_GRID_H
+
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "min_distance_cpu.h"		// MAX_CPU_THREADS
+#include "reduction.h"
+
+#define POINTS_PER_CELL	2		// Average no. of points per cell
+
+struct point_grid {
+    int n;				// Number of points
+    float x_min, y_min;			// Lower left corner of the grid
+    float cell_size;			// Side of a cell
+    int nx, ny;				// Number of cells in x and y
+    int * cell_start;			// Points of cell c: cell_start[c] ... cell_start[c+1]-1
+    float * X, * Y;			// Coordinates of the points, ordered by cell
+    int * index;			// index[k] = original index of kth point
+};
+
+struct point_grid_job {
+    struct point_grid * grid;
+    const float * X, * Y;		// Coordinates of the points, original order
+    float * row_X, * row_Y;		// Coordinates of the points, ordered by row
+    int * row_index;			// Original index of the points, ordered by row
+    int * cell;				// cell[i] = cell of ith point, original order
+    int * row_cell;			// Cell of the points, ordered by row
+    int * row_count;			// row_count[t*ny+r] = points of chunk t in row r,
+					// then next position of these points
+    int * row_start;			// Points of row r: row_start[r] ... row_start[r+1]-1
+    int next_row;			// Next row of cells to take; taken atomically
+    float x_min[MAX_CPU_THREADS], x_max[MAX_CPU_THREADS];	// Bounding box of each chunk
+    float y_min[MAX_CPU_THREADS], y_max[MAX_CPU_THREADS];
+    float min_distance2;		// Minimum squared distance; threads combine into it
+    float candidate2;			// Refine pairs at squared distance <= candidate2
+    const double * Xd, * Yd;		// Double coordinates for refinement, or NULL
+    double refined[MAX_CPU_THREADS];	// Minimum refined squared distance of each thread
+};
+
+struct point_grid_arg {
+    struct point_grid_job * job;
+    int id, num_threads;
+};
+
+// ----------------------------------------------------------------------------
+// Run fn on num_threads threads; calling thread works as thread 0
+static void point_grid_run_threads(void *(*fn)(void *), struct point_grid_arg * args,
+	int num_threads) {
+    pthread_t threads[MAX_CPU_THREADS];
+    int t;
+    for (t = 1; t < num_threads; t++) {
+	pthread_create(&threads[t], NULL, fn, (void *) &args[t]);
+    }
+    fn((void *) &args[0]);
+    for (t = 1; t < num_threads; t++) {
+	pthread_join(threads[t], NULL);
+    }
+}
+
+// First point of the chunk of thread id
+static inline int point_grid_chunk(int n, int id, int num_threads) {
+    return (int) ((long long) n*id/num_threads);
+}
+
+// Cell coordinate of v along an axis with n_cells cells
+static inline int point_grid_cell_coord(float v, float v_min, float cell_size, int n_cells) {
+    int c = (int) ((v-v_min)/cell_size);
+    return (c < 0) ? 0 : ((c >= n_cells) ? n_cells-1 : c);
+}
+
+// Thread functions of build: bounding box, cell counts, scatter by cell
+static void *point_grid_bbox_thread(void *s) {
+    struct point_grid_arg * arg = (struct point_grid_arg *) s;
+    struct point_grid_job * job = arg->job;
+    int first = point_grid_chunk(job->grid->n, arg->id, arg->num_threads);
+    int last = point_grid_chunk(job->grid->n, arg->id+1, arg->num_threads);
+    float x_min = FLT_MAX, x_max = -FLT_MAX, y_min = FLT_MAX, y_max = -FLT_MAX;
+    int i;
+    for (i = first; i < last; i++) {
+	if (job->X[i] < x_min) x_min = job->X[i];
+	if (job->X[i] > x_max) x_max = job->X[i];
+	if (job->Y[i] < y_min) y_min = job->Y[i];
+	if (job->Y[i] > y_max) y_max = job->Y[i];
+    }
+    job->x_min[arg->id] = x_min; job->x_max[arg->id] = x_max;
+    job->y_min[arg->id] = y_min; job->y_max[arg->id] = y_max;
+    return NULL;
+}
+
+static void *point_grid_count_thread(void *s) {
+    struct point_grid_arg * arg = (struct point_grid_arg *) s;
+    struct point_grid_job * job = arg->job;
+    struct point_grid * grid = job->grid;
+    int * count = &job->row_count[arg->id*grid->ny];
+    int first = point_grid_chunk(grid->n, arg->id, arg->num_threads);
+    int last = point_grid_chunk(grid->n, arg->id+1, arg->num_threads);
+    int i, r;
+    for (i = first; i < last; i++) {
+	r = point_grid_cell_coord(job->Y[i], grid->y_min, grid->cell_size, grid->ny);
+	job->cell[i] = r*grid->nx
+	    + point_grid_cell_coord(job->X[i], grid->x_min, grid->cell_size, grid->nx);
+	count[r]++;
+    }
+    return NULL;
+}
+
+static void *point_grid_row_scatter_thread(void *s) {
+    struct point_grid_arg * arg = (struct point_grid_arg *) s;
+    struct point_grid_job * job = arg->job;
+    struct point_grid * grid = job->grid;
+    int * next = &job->row_count[arg->id*grid->ny];
+    int first = point_grid_chunk(grid->n, arg->id, arg->num_threads);
+    int last = point_grid_chunk(grid->n, arg->id+1, arg->num_threads);
+    int i, k;
+    for (i = first; i < last; i++) {
+	k = next[job->cell[i]/grid->nx]++;
+	job->row_X[k] = job->X[i];
+	job->row_Y[k] = job->Y[i];
+	job->row_index[k] = i;
+	job->row_cell[k] = job->cell[i];
+    }
+    return NULL;
+}
+
+static void *point_grid_cell_scatter_thread(void *s) {
+    struct point_grid_arg * arg = (struct point_grid_arg *) s;
+    struct point_grid_job * job = arg->job;
+    struct point_grid * grid = job->grid;
+    int * start = grid->cell_start;
+    int nx = grid->nx;
+    int r, c, k, m, first, last;
+    while ((r = __atomic_fetch_add(&job->next_row, 1, __ATOMIC_RELAXED)) < grid->ny) {
+	// Points of row r are row_*[first ... last-1]; only cells of row r
+	// are touched, so rows are independent
+	first = job->row_start[r];
+	last = job->row_start[r+1];
+	for (k = first; k < last; k++) {
+	    start[job->row_cell[k]]++;
+	}
+	for (c = r*nx, k = first; c < (r+1)*nx; c++) {
+	    m = start[c];
+	    start[c] = k;
+	    k += m;
+	}
+	for (k = first; k < last; k++) {
+	    m = start[job->row_cell[k]]++;
+	    grid->X[m] = job->row_X[k];
+	    grid->Y[m] = job->row_Y[k];
+	    grid->index[m] = job->row_index[k];
+	}
+	// Scatter advanced start[c] to the start of cell c+1: shift back
+	for (c = (r+1)*nx-1; c > r*nx; c--) {
+	    start[c] = start[c-1];
+	}
+	start[r*nx] = first;
+    }
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+// Build grid index of points
+// Input:
+//	X: X[i] = x-coordinate of the ith point
+//	Y: Y[i] = y-coordinate of the ith point
+//	n: number of points
+//	cell_size: side of a cell; if <= 0, chosen so that a cell holds
+//		   POINTS_PER_CELL points on average
+//	num_threads: number of threads
+// Output:
+//	grid: grid index; cell_size may be larger than requested, so that
+//	      the grid has at most about 4n cells
+//
+void point_grid_build(struct point_grid * grid, const float * X, const float * Y, int n,
+	float cell_size, int num_threads) {
+    struct point_grid_job job;
+    struct point_grid_arg args[MAX_CPU_THREADS];
+    float x_max = -FLT_MAX, y_max = -FLT_MAX, width, height;
+    int num_cells, r, k, m, t;
+
+    if (num_threads < 1) num_threads = 1;
+    if (num_threads > MAX_CPU_THREADS) num_threads = MAX_CPU_THREADS;
+    if (num_threads > n) num_threads = (n > 0) ? n : 1;
+    for (t = 0; t < num_threads; t++) {
+	args[t].job = &job;
+	args[t].id = t;
+	args[t].num_threads = num_threads;
+    }
+    job.grid = grid; job.X = X; job.Y = Y;
+    grid->n = n;
+
+    // Bounding box
+    point_grid_run_threads(point_grid_bbox_thread, args, num_threads);
+    grid->x_min = FLT_MAX; grid->y_min = FLT_MAX;
+    for (t = 0; t < num_threads; t++) {
+	if (job.x_min[t] < grid->x_min) grid->x_min = job.x_min[t];
+	if (job.y_min[t] < grid->y_min) grid->y_min = job.y_min[t];
+	if (job.x_max[t] > x_max) x_max = job.x_max[t];
+	if (job.y_max[t] > y_max) y_max = job.y_max[t];
+    }
+    if (n == 0) {
+	grid->x_min = grid->y_min = x_max = y_max = 0.0f;
+    }
+    width = x_max-grid->x_min;
+    height = y_max-grid->y_min;
+
+    // Cell size and number of cells
+    if (cell_size <= 0.0f) {
+	cell_size = sqrtf(width*height*POINTS_PER_CELL/(n > 0 ? n : 1));
+	if (cell_size <= 0.0f) cell_size = (width+height)*POINTS_PER_CELL/(n > 0 ? n : 1);
+	if (cell_size <= 0.0f) cell_size = 1.0f;	// All points coincide
+    }
+    while ((double) ((int) (width/cell_size)+1)*((int) (height/cell_size)+1) > 4.0*n+16) {
+	cell_size *= 2.0f;
+    }
+    grid->cell_size = cell_size;
+    grid->nx = (int) (width/cell_size)+1;
+    grid->ny = (int) (height/cell_size)+1;
+    num_cells = grid->nx*grid->ny;
+
+    // Count points of each chunk per row, scatter points by row, then
+    // sort points of each row by cell
+    grid->cell_start = (int *) calloc(num_cells+1, sizeof(int));
+    grid->X = (float *) malloc(n*sizeof(float));
+    grid->Y = (float *) malloc(n*sizeof(float));
+    grid->index = (int *) malloc(n*sizeof(int));
+    job.cell = (int *) malloc(n*sizeof(int));
+    job.row_count = (int *) calloc(num_threads*grid->ny, sizeof(int));
+    job.row_start = (int *) malloc((grid->ny+1)*sizeof(int));
+    point_grid_run_threads(point_grid_count_thread, args, num_threads);
+    for (r = 0, k = 0; r < grid->ny; r++) {
+	job.row_start[r] = k;
+	for (t = 0; t < num_threads; t++) {
+	    m = job.row_count[t*grid->ny+r];
+	    job.row_count[t*grid->ny+r] = k;
+	    k += m;
+	}
+    }
+    job.row_start[grid->ny] = n;
+    job.row_X = (float *) malloc(n*sizeof(float));
+    job.row_Y = (float *) malloc(n*sizeof(float));
+    job.row_index = (int *) malloc(n*sizeof(int));
+    job.row_cell = (int *) malloc(n*sizeof(int));
+    point_grid_run_threads(point_grid_row_scatter_thread, args, num_threads);
+    free(job.cell);
+    job.next_row = 0;
+    point_grid_run_threads(point_grid_cell_scatter_thread, args, num_threads);
+    grid->cell_start[num_cells] = n;
+    free(job.row_X); free(job.row_Y); free(job.row_index); free(job.row_cell);
+    free(job.row_count); free(job.row_start);
+}
+
+// Free grid arrays
+void point_grid_free(struct point_grid * grid) {
+    free(grid->cell_start); free(grid->X); free(grid->Y); free(grid->index);
+}
+
+// ----------------------------------------------------------------------------
+// Minimum squared distance between point (xi, yi) and points first ...
+// last-1; ranges hold a few points, too few for the SIMD loop of
+// min_distance_tiled.h (see above)
+static inline float point_range_min_distance2(float xi, float yi, const float * X,
+	const float * Y, int first, int last) {
+    float min_distance2 = FLT_MAX;
+    float dx, dy, D2ij;
+    int j;
+    for (j = first; j < last; j++) {
+	dx = X[j]-xi;
+	dy = Y[j]-yi;
+	D2ij = dx*dx+dy*dy;
+	if (D2ij < min_distance2) min_distance2 = D2ij;
+    }
+    return min_distance2;
+}
+
+// Thread function: take rows of cells until none are left
+static void *point_grid_min_distance_thread(void *s) {
+    struct point_grid_arg * arg = (struct point_grid_arg *) s;
+    struct point_grid_job * job = arg->job;
+    struct point_grid * grid = job->grid;
+    const int * start = grid->cell_start;
+    int nx = grid->nx;
+    float min_distance2 = FLT_MAX, D2ij;
+    int cx, cy, k, row, below, same_last, below_first, below_last;
+    while ((cy = __atomic_fetch_add(&job->next_row, 1, __ATOMIC_RELAXED)) < grid->ny) {
+	row = cy*nx;
+	below = row+nx;
+	for (cx = 0; cx < nx; cx++) {
+	    // Same cell and next cell in row; cells cx-1 ... cx+1 in next row
+	    same_last = start[row+((cx+2 < nx) ? cx+2 : nx)];
+	    if (cy+1 < grid->ny) {
+		below_first = start[below+((cx > 0) ? cx-1 : 0)];
+		below_last = start[below+((cx+2 < nx) ? cx+2 : nx)];
+	    } else {
+		below_first = below_last = 0;
+	    }
+	    for (k = start[row+cx]; k < start[row+cx+1]; k++) {
+		D2ij = point_range_min_distance2(grid->X[k], grid->Y[k], grid->X, grid->Y, k+1, same_last);
+		if (D2ij < min_distance2) min_distance2 = D2ij;
+		D2ij = point_range_min_distance2(grid->X[k], grid->Y[k], grid->X, grid->Y,
+			below_first, below_last);
+		if (D2ij < min_distance2) min_distance2 = D2ij;
+	    }
+	}
+    }
+    reduce_min_combine(&job->min_distance2, min_distance2);
+    return NULL;
+}
+
+// Minimum distance between points in the same or adjacent cells of grid
+// Input:
+//	grid: grid index
+//	num_threads: number of threads
+// Output:
+//	minimum distance; it is the minimum distance between all points
+//	if it is (clearly) smaller than grid->cell_size. FLT_MAX if no two points
+//	are in the same or adjacent cells
+//
+float point_grid_min_distance(struct point_grid * grid, int num_threads) {
+    struct point_grid_job job;
+    struct point_grid_arg args[MAX_CPU_THREADS];
+    int t;
+
+    if (num_threads < 1) num_threads = 1;
+    if (num_threads > MAX_CPU_THREADS) num_threads = MAX_CPU_THREADS;
+    job.grid = grid;
+    job.next_row = 0;
+    job.min_distance2 = REDUCTION_MIN_IDENTITY;
+    for (t = 0; t < num_threads; t++) {
+	args[t].job = &job;
+	args[t].id = t;
+	args[t].num_threads = num_threads;
+    }
+    point_grid_run_threads(point_grid_min_distance_thread, args, num_threads);
+    return (job.min_distance2 < FLT_MAX) ? sqrtf(job.min_distance2) : FLT_MAX;
+}
+
+// ----------------------------------------------------------------------------
+// Minimum squared distance, in double, between point k and the points
+// first ... last-1 at squared float distance <= job->candidate2
+static inline double point_range_refine2(const struct point_grid_job * job, int k, int first,
+	int last) {
+    const struct point_grid * grid = job->grid;
+    double min_distance2 = DBL_MAX, ddx, ddy;
+    float dx, dy;
+    int j;
+    for (j = first; j < last; j++) {
+	dx = grid->X[j]-grid->X[k];
+	dy = grid->Y[j]-grid->Y[k];
+	if (dx*dx+dy*dy > job->candidate2) continue;
+	if (job->Xd != NULL) {
+	    ddx = job->Xd[grid->index[j]]-job->Xd[grid->index[k]];
+	    ddy = job->Yd[grid->index[j]]-job->Yd[grid->index[k]];
+	} else {
+	    ddx = (double) grid->X[j]-(double) grid->X[k];
+	    ddy = (double) grid->Y[j]-(double) grid->Y[k];
+	}
+	if (ddx*ddx+ddy*ddy < min_distance2) min_distance2 = ddx*ddx+ddy*ddy;
+    }
+    return min_distance2;
+}
+
+// Thread function: take rows of cells until none are left
+static void *point_grid_refine_thread(void *s) {
+    struct point_grid_arg * arg = (struct point_grid_arg *) s;
+    struct point_grid_job * job = arg->job;
+    struct point_grid * grid = job->grid;
+    const int * start = grid->cell_start;
+    int nx = grid->nx;
+    double min_distance2 = DBL_MAX, D2ij;
+    int cx, cy, k, row, below, same_last, below_first, below_last;
+    while ((cy = __atomic_fetch_add(&job->next_row, 1, __ATOMIC_RELAXED)) < grid->ny) {
+	row = cy*nx;
+	below = row+nx;
+	for (cx = 0; cx < nx; cx++) {
+	    same_last = start[row+((cx+2 < nx) ? cx+2 : nx)];
+	    if (cy+1 < grid->ny) {
+		below_first = start[below+((cx > 0) ? cx-1 : 0)];
+		below_last = start[below+((cx+2 < nx) ? cx+2 : nx)];
+	    } else {
+		below_first = below_last = 0;
+	    }
+	    for (k = start[row+cx]; k < start[row+cx+1]; k++) {
+		D2ij = point_range_refine2(job, k, k+1, same_last);
+		if (D2ij < min_distance2) min_distance2 = D2ij;
+		D2ij = point_range_refine2(job, k, below_first, below_last);
+		if (D2ij < min_distance2) min_distance2 = D2ij;
+	    }
+	}
+    }
+    job->refined[arg->id] = min_distance2;
+    return NULL;
+}
+
+// Minimum distance, in double, between points in the same or adjacent
+// cells of grid that are within distance bound in float
+// Input:
+//	grid: grid index
+//	bound: largest float distance of pairs to refine
+//	Xd, Yd: double coordinates of the points (original order), or
+//		NULL to use the float coordinates of the grid
+//	num_threads: number of threads
+// Output:
+//	minimum distance (DBL_MAX if no pair is within bound)
+//
+double point_grid_refine_min_distance(struct point_grid * grid, float bound, const double * Xd,
+	const double * Yd, int num_threads) {
+    struct point_grid_job job;
+    struct point_grid_arg args[MAX_CPU_THREADS];
+    double min_distance2 = DBL_MAX;
+    int t;
+
+    if (num_threads < 1) num_threads = 1;
+    if (num_threads > MAX_CPU_THREADS) num_threads = MAX_CPU_THREADS;
+    job.grid = grid;
+    job.next_row = 0;
+    job.candidate2 = bound*bound;
+    job.Xd = Xd; job.Yd = Yd;
+    for (t = 0; t < num_threads; t++) {
+	args[t].job = &job;
+	args[t].id = t;
+	args[t].num_threads = num_threads;
+    }
+    point_grid_run_threads(point_grid_refine_thread, args, num_threads);
+    for (t = 0; t < num_threads; t++) {
+	if (job.refined[t] < min_distance2) min_distance2 = job.refined[t];
+    }
+    return (min_distance2 < DBL_MAX) ? sqrt(min_distance2) : DBL_MAX;
+}
+
+// ----------------------------------------------------------------------------
+// Compute minimum distance between points with a grid index
+// Input:
+//	X: X[i] = x-coordinate of the ith point
+//	Y: Y[i] = y-coordinate of the ith point
+//	n: number of points (at least 2)
+//	num_threads: number of threads
+// Output:
+//	minimum distance
+//
+float minimum_distance_grid(float * X, float * Y, int n, int num_threads) {
+    struct point_grid grid;
+    float min_distance, cell_size = 0.0f;
+
+    while (1) {
+	point_grid_build(&grid, X, Y, n, cell_size, num_threads);
+	min_distance = point_grid_min_distance(&grid, num_threads);
+	// Margin covers rounding of cell coordinates
+	if ((1.0001f*min_distance < grid.cell_size) || (grid.nx*grid.ny == 1)) break;
+	// Closest pair may be in cells that are not adjacent: larger cells
+	cell_size = (min_distance < FLT_MAX) ? 1.001f*min_distance : 2.0f*grid.cell_size;
+	point_grid_free(&grid);
+    }
+    point_grid_free(&grid);
+    return min_distance;
+}
+
+// Compute minimum distance between points with a grid index, evaluated
+// in double
+// Input:
+//	X: X[i] = x-coordinate of the ith point (float)
+//	Y: Y[i] = y-coordinate of the ith point (float)
+//	Xd, Yd: double coordinates of the points, of which X and Y are
+//		the rounded values; NULL if the points are X and Y
+//	n: number of points (at least 2)
+//	num_threads: number of threads
+// Output:
+//	minimum distance
+//
+double minimum_distance_grid_refined(const float * X, const float * Y, const double * Xd,
+	const double * Yd, int n, int num_threads) {
+    struct point_grid grid;
+    float min_distance, bound, max_coord, cell_size = 0.0f;
+    double refined;
+
+    while (1) {
+	point_grid_build(&grid, X, Y, n, cell_size, num_threads);
+	min_distance = point_grid_min_distance(&grid, num_threads);
+	// Closest pair in double is within bound in float: rounding of
+	// squared distances, and of coordinates if they are rounded from
+	// Xd and Yd
+	max_coord = fmaxf(fmaxf(fabsf(grid.x_min), fabsf(grid.x_min+grid.nx*grid.cell_size)),
+		fmaxf(fabsf(grid.y_min), fabsf(grid.y_min+grid.ny*grid.cell_size)));
+	bound = (min_distance+((Xd != NULL) ? 3.0f*FLT_EPSILON*max_coord : 0.0f))
+	    *(1.0f+(float) REFINE_TOLERANCE);
+	if ((min_distance < FLT_MAX) && ((1.0001f*bound < grid.cell_size) || (grid.nx*grid.ny == 1))) break;
+	// Pairs to refine may be in cells that are not adjacent: larger cells
+	cell_size = (min_distance < FLT_MAX) ? 1.001f*bound : 2.0f*grid.cell_size;
+	point_grid_free(&grid);
+    }
+    refined = point_grid_refine_min_distance(&grid, bound, Xd, Yd, num_threads);
+    point_grid_free(&grid);
+    return refined;
+}
+
+#endif
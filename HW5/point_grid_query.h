@@ -0,0 +1,314 @@
+// ----------------------------------------------------------------------------
+// Header file with nearest-neighbor and radius queries on a grid index of
+// points (point_grid.h)
+//
+// The grid is built once and queried many times. A k-nearest-neighbor
+// query visits rings of cells around the cell of the query point: all
+// points in cells outside ring r are at distance more than r*cell_size
+// from it, so the search stops after ring r once k points within that
+// distance are known. A radius query visits the cells that overlap the
+// square around the query point; the cells of a row are one contiguous
+// range of points.
+//
+// The all-points queries run on num_threads threads, which take rows of
+// cells from a shared counter, so that consecutive queries touch the same
+// cells. Distances are compared squared; results are distances.
+//
+// Contains following routines
+//
+//    point_grid_knn(&grid, x, y, k, exclude, nbr, dist)
+//	- k nearest points to (x, y)
+//
+//    point_grid_radius(&grid, x, y, radius, &nbr, &capacity)
+//	- points within radius of (x, y)
+//
+//    point_grid_all_knn(&grid, k, nbr, dist, num_threads)
+//	- k nearest other points of every point
+//
+//    point_grid_pairs_within(&grid, radius, &pairs, &capacity, num_threads)
+//	- all pairs of points within radius of each other
+//
+#ifndef POINT_GRID_QUERY_H
+#define POINT_GRID_QUERY_H
+
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "point_grid.h"
+
+struct point_grid_query_job {
+    const struct point_grid * grid;
+    int k;				// Number of neighbors (all_knn)
+    int * nbr;				// Neighbors of each point (all_knn)
+    float * dist;			// Distances to neighbors (all_knn)
+    float radius;			// Radius (pairs_within)
+    int * pairs[MAX_CPU_THREADS];	// Pairs found by each thread (pairs_within)
+    long long num_pairs[MAX_CPU_THREADS];
+    int next_row;			// Next row of cells to take; taken atomically
+};
+
+struct point_grid_query_arg {
+    struct point_grid_query_job * job;
+    int id;
+};
+
+// ----------------------------------------------------------------------------
+// Insert point j at squared distance d2 into the sorted lists nbr/d2_list
+// of found (< k) or k nearest points; returns new number of points
+static inline int knn_insert(int * nbr, float * d2_list, int found, int k, int j, float d2) {
+    int m;
+    if ((found == k) && (d2 >= d2_list[k-1])) return found;
+    m = (found < k) ? found++ : k-1;
+    for (; (m > 0) && (d2_list[m-1] > d2); m--) {
+	nbr[m] = nbr[m-1];
+	d2_list[m] = d2_list[m-1];
+    }
+    nbr[m] = j;
+    d2_list[m] = d2;
+    return found;
+}
+
+// Visit points of cells cx_first ... cx_last of row cy
+static inline int knn_visit_cells(const struct point_grid * grid, float x, float y, int k,
+	int exclude, int * nbr, float * d2_list, int found, int cy, int cx_first, int cx_last) {
+    float dx, dy;
+    int j, row = cy*grid->nx;
+    if ((cy < 0) || (cy >= grid->ny)) return found;
+    if (cx_first < 0) cx_first = 0;
+    if (cx_last >= grid->nx) cx_last = grid->nx-1;
+    if (cx_first > cx_last) return found;
+    for (j = grid->cell_start[row+cx_first]; j < grid->cell_start[row+cx_last+1]; j++) {
+	if (grid->index[j] == exclude) continue;
+	dx = grid->X[j]-x;
+	dy = grid->Y[j]-y;
+	found = knn_insert(nbr, d2_list, found, k, grid->index[j], dx*dx+dy*dy);
+    }
+    return found;
+}
+
+// ----------------------------------------------------------------------------
+// Find k nearest points to (x, y)
+// Input:
+//	grid: grid index
+//	x, y: query point
+//	k: number of neighbors
+//	exclude: original index of a point to skip (the query point
+//		 itself), or -1
+// Output:
+//	nbr: nbr[m] = original index of (m+1)th nearest point
+//	dist: dist[m] = its distance to (x, y)
+//	returns number of neighbors found, k unless the grid has fewer
+//	points
+//
+int point_grid_knn(const struct point_grid * grid, float x, float y, int k, int exclude,
+	int * nbr, float * dist) {
+    int cx = point_grid_cell_coord(x, grid->x_min, grid->cell_size, grid->nx);
+    int cy = point_grid_cell_coord(y, grid->y_min, grid->cell_size, grid->ny);
+    int max_ring = (grid->nx > grid->ny) ? grid->nx : grid->ny;
+    float bound;
+    int found = 0, r, m;
+
+    if (k <= 0) return 0;
+    // dist holds squared distances until the end
+    for (r = 0; r <= max_ring; r++) {
+	// Rows cy-r and cy+r in full, columns cx-r and cx+r in between
+	found = knn_visit_cells(grid, x, y, k, exclude, nbr, dist, found, cy-r, cx-r, cx+r);
+	if (r > 0) {
+	    found = knn_visit_cells(grid, x, y, k, exclude, nbr, dist, found, cy+r, cx-r, cx+r);
+	    for (m = cy-r+1; m < cy+r; m++) {
+		found = knn_visit_cells(grid, x, y, k, exclude, nbr, dist, found, m, cx-r, cx-r);
+		found = knn_visit_cells(grid, x, y, k, exclude, nbr, dist, found, m, cx+r, cx+r);
+	    }
+	}
+	bound = r*grid->cell_size;
+	if ((found == k) && (dist[k-1] <= bound*bound)) break;
+    }
+    for (m = 0; m < found; m++) {
+	dist[m] = sqrtf(dist[m]);
+    }
+    return found;
+}
+
+// Find points within radius of (x, y)
+// Input:
+//	grid: grid index
+//	x, y: query point
+//	radius: radius
+//	nbr, capacity: malloc'ed buffer (or NULL) and its size in ints
+// Output:
+//	nbr: original indices of the points within radius; the buffer is
+//	     reallocated (and capacity updated) if it is too small
+//	returns number of points within radius
+//
+int point_grid_radius(const struct point_grid * grid, float x, float y, float radius,
+	int ** nbr, int * capacity) {
+    int cx_first = point_grid_cell_coord(x-radius, grid->x_min, grid->cell_size, grid->nx);
+    int cx_last = point_grid_cell_coord(x+radius, grid->x_min, grid->cell_size, grid->nx);
+    int cy_first = point_grid_cell_coord(y-radius, grid->y_min, grid->cell_size, grid->ny);
+    int cy_last = point_grid_cell_coord(y+radius, grid->y_min, grid->cell_size, grid->ny);
+    float dx, dy, radius2 = radius*radius;
+    int found = 0, cy, j;
+
+    for (cy = cy_first; cy <= cy_last; cy++) {
+	for (j = grid->cell_start[cy*grid->nx+cx_first]; j < grid->cell_start[cy*grid->nx+cx_last+1]; j++) {
+	    dx = grid->X[j]-x;
+	    dy = grid->Y[j]-y;
+	    if (dx*dx+dy*dy > radius2) continue;
+	    if (found == *capacity) {
+		*capacity = (*capacity > 0) ? 2*(*capacity) : 64;
+		*nbr = (int *) realloc(*nbr, (*capacity)*sizeof(int));
+	    }
+	    (*nbr)[found++] = grid->index[j];
+	}
+    }
+    return found;
+}
+
+// ----------------------------------------------------------------------------
+// Thread functions: take rows of cells until none are left
+static void *point_grid_all_knn_thread(void *s) {
+    struct point_grid_query_arg * arg = (struct point_grid_query_arg *) s;
+    struct point_grid_query_job * job = arg->job;
+    const struct point_grid * grid = job->grid;
+    int k = job->k;
+    int cy, j, i, m, found;
+    while ((cy = __atomic_fetch_add(&job->next_row, 1, __ATOMIC_RELAXED)) < grid->ny) {
+	for (j = grid->cell_start[cy*grid->nx]; j < grid->cell_start[(cy+1)*grid->nx]; j++) {
+	    i = grid->index[j];
+	    found = point_grid_knn(grid, grid->X[j], grid->Y[j], k, i, &job->nbr[(long long) i*k],
+		    &job->dist[(long long) i*k]);
+	    for (m = found; m < k; m++) {
+		job->nbr[(long long) i*k+m] = -1;
+		job->dist[(long long) i*k+m] = FLT_MAX;
+	    }
+	}
+    }
+    return NULL;
+}
+
+static void *point_grid_pairs_within_thread(void *s) {
+    struct point_grid_query_arg * arg = (struct point_grid_query_arg *) s;
+    struct point_grid_query_job * job = arg->job;
+    const struct point_grid * grid = job->grid;
+    float radius2 = job->radius*job->radius;
+    float dx, dy;
+    int cy, cy_last, cx_first, cx_last, j, m, m_first;
+    int * pairs = NULL;
+    long long num_pairs = 0, capacity = 0;
+    // Point j is paired with the points after it in rows cy ... cy_last
+    // that are within radius
+    while ((cy = __atomic_fetch_add(&job->next_row, 1, __ATOMIC_RELAXED)) < grid->ny) {
+	for (j = grid->cell_start[cy*grid->nx]; j < grid->cell_start[(cy+1)*grid->nx]; j++) {
+	    cx_first = point_grid_cell_coord(grid->X[j]-job->radius, grid->x_min, grid->cell_size, grid->nx);
+	    cx_last = point_grid_cell_coord(grid->X[j]+job->radius, grid->x_min, grid->cell_size, grid->nx);
+	    cy_last = point_grid_cell_coord(grid->Y[j]+job->radius, grid->y_min, grid->cell_size, grid->ny);
+	    for (m = cy; m <= cy_last; m++) {
+		m_first = grid->cell_start[m*grid->nx+cx_first];
+		if ((m == cy) && (m_first <= j)) m_first = j+1;
+		for (; m_first < grid->cell_start[m*grid->nx+cx_last+1]; m_first++) {
+		    dx = grid->X[m_first]-grid->X[j];
+		    dy = grid->Y[m_first]-grid->Y[j];
+		    if (dx*dx+dy*dy > radius2) continue;
+		    if (num_pairs == capacity) {
+			capacity = (capacity > 0) ? 2*capacity : 1024;
+			pairs = (int *) realloc(pairs, 2*capacity*sizeof(int));
+		    }
+		    pairs[2*num_pairs] = grid->index[j];
+		    pairs[2*num_pairs+1] = grid->index[m_first];
+		    num_pairs++;
+		}
+	    }
+	}
+    }
+    job->pairs[arg->id] = pairs;
+    job->num_pairs[arg->id] = num_pairs;
+    return NULL;
+}
+
+// Run fn on num_threads threads; calling thread works as thread 0
+static void point_grid_query_run_threads(void *(*fn)(void *), struct point_grid_query_job * job,
+	int num_threads) {
+    struct point_grid_query_arg args[MAX_CPU_THREADS];
+    pthread_t threads[MAX_CPU_THREADS];
+    int t;
+    job->next_row = 0;
+    for (t = 0; t < num_threads; t++) {
+	args[t].job = job;
+	args[t].id = t;
+    }
+    for (t = 1; t < num_threads; t++) {
+	pthread_create(&threads[t], NULL, fn, (void *) &args[t]);
+    }
+    fn((void *) &args[0]);
+    for (t = 1; t < num_threads; t++) {
+	pthread_join(threads[t], NULL);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Find k nearest other points of every point
+// Input:
+//	grid: grid index
+//	k: number of neighbors
+//	num_threads: number of threads
+// Output:
+//	nbr: nbr[i*k+m] = original index of (m+1)th nearest point to
+//	     point i, or -1 if there are fewer than k other points
+//	dist: dist[i*k+m] = its distance to point i (FLT_MAX if none)
+//
+void point_grid_all_knn(const struct point_grid * grid, int k, int * nbr, float * dist,
+	int num_threads) {
+    struct point_grid_query_job job;
+    if (num_threads < 1) num_threads = 1;
+    if (num_threads > MAX_CPU_THREADS) num_threads = MAX_CPU_THREADS;
+    job.grid = grid;
+    job.k = k;
+    job.nbr = nbr;
+    job.dist = dist;
+    point_grid_query_run_threads(point_grid_all_knn_thread, &job, num_threads);
+}
+
+// Find all pairs of points within radius of each other
+// Input:
+//	grid: grid index
+//	radius: radius
+//	pairs, capacity: malloc'ed buffer (or NULL) and its size in pairs
+//	num_threads: number of threads
+// Output:
+//	pairs: pairs[2p], pairs[2p+1] = original indices of the points of
+//	       pth pair; the buffer is reallocated (and capacity updated)
+//	       if it is too small
+//	returns number of pairs
+//
+long long point_grid_pairs_within(const struct point_grid * grid, float radius, int ** pairs,
+	long long * capacity, int num_threads) {
+    struct point_grid_query_job job;
+    long long num_pairs = 0;
+    int t;
+    if (num_threads < 1) num_threads = 1;
+    if (num_threads > MAX_CPU_THREADS) num_threads = MAX_CPU_THREADS;
+    job.grid = grid;
+    job.radius = radius;
+    point_grid_query_run_threads(point_grid_pairs_within_thread, &job, num_threads);
+
+    // Concatenate pairs found by the threads
+    for (t = 0; t < num_threads; t++) {
+	num_pairs += job.num_pairs[t];
+    }
+    if (num_pairs > *capacity) {
+	*capacity = num_pairs;
+	*pairs = (int *) realloc(*pairs, 2*(*capacity)*sizeof(int));
+    }
+    for (t = 0, num_pairs = 0; t < num_threads; t++) {
+	if (job.num_pairs[t] > 0) {
+	    memcpy(&(*pairs)[2*num_pairs], job.pairs[t], 2*job.num_pairs[t]*sizeof(int));
+	}
+	num_pairs += job.num_pairs[t];
+	free(job.pairs[t]);
+    }
+    return num_pairs;
+}
+
+#endif
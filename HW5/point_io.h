@@ -0,0 +1,280 @@
+// ----------------------------------------------------------------------------
+// Header file with routines to save and load point sets in a binary file
+//
+// File format (native byte order), structure of arrays:
+//
+//   bytes 0 ... 63		header (struct point_file_header): magic
+//				"POINTS2D", version, size of a coordinate
+//				(4 float, 8 double), number of points n and
+//				offsets of the coordinate arrays
+//   x_offset ...		X[0 ... n-1]
+//   y_offset ...		Y[0 ... n-1]
+//
+// Both arrays start at a multiple of POINT_FILE_ALIGN bytes, so a mapped
+// file can be used in place by the SIMD loops of the engines: a float
+// file is mapped read-only and its arrays are used without a copy (pages
+// are read on first access). Files too large to map, or to hold in memory,
+// are read in chunks of points with pread, and written in chunks with
+// pwrite at the position of each chunk in both arrays.
+//
+// Contains following routines
+//
+//    point_file_create(&file, path, n, coord_size)
+//	- create file for n points with coordinates of coord_size bytes
+//
+//    point_file_write(&file, first, X, Y, count)
+//	- write points first ... first+count-1
+//
+//    point_file_save(path, X, Y, n), point_file_save_double(path, X, Y, n)
+//	- write n float (double) points to a new file
+//
+//    point_file_open(&file, path)
+//	- open file for reading, check its header
+//
+//    point_file_read(&file, first, X, Y, count)
+//	- read points first ... first+count-1 as floats
+//
+//    point_file_map(&file)
+//	- map whole file; file.X, file.Y (float files) or file.Xd, file.Yd
+//	  (double files) point into it
+//
+//    point_file_floats(&file, &X, &Y), point_file_doubles(&file, &X, &Y)
+//	- coordinates of a mapped file as float (double) arrays: in place if
+//	  the file has that type, otherwise converted copies (returns 1 if
+//	  the arrays were allocated and must be freed)
+//
+//    point_file_close(&file)
+//	- unmap and close file
+//
+//    point_file_arg(arg)
+//	- 1 if a command line argument is a file path rather than a number
+//	  of points
+//
+// Errors (cannot open, write or map a file, or not a point file) print a
+// message and abort.
+//
+#ifndef POINT_IO_H
+#define POINT_IO_H
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define POINT_FILE_MAGIC	"POINTS2D"
+#define POINT_FILE_VERSION	1
+#define POINT_FILE_ALIGN	64		// Alignment of coordinate arrays (bytes)
+#define POINT_FILE_CHUNK	(1 << 20)	// Points per chunk of converted reads
+
+struct point_file_header {
+    char magic[8];			// POINT_FILE_MAGIC, not terminated
+    uint32_t version;			// POINT_FILE_VERSION
+    uint32_t coord_size;		// Bytes per coordinate: 4 (float) or 8 (double)
+    uint64_t n;				// Number of points
+    uint64_t x_offset, y_offset;	// Byte offsets of X and Y arrays
+    char reserved[24];
+};
+
+struct point_file {
+    int fd;
+    const char * path;
+    struct point_file_header header;
+    int n;				// Number of points
+    void * map;				// Mapped file, or NULL
+    size_t map_size;
+    const float * X, * Y;		// Mapped arrays of a float file, or NULL
+    const double * Xd, * Yd;		// Mapped arrays of a double file, or NULL
+};
+
+static void point_file_abort(const char * what, const char * path) {
+    printf("%s %s. Aborting ...\n", what, path);
+    exit(1);
+}
+
+static inline uint64_t point_file_align(uint64_t offset) {
+    return (offset+POINT_FILE_ALIGN-1)/POINT_FILE_ALIGN*POINT_FILE_ALIGN;
+}
+
+// Transfer size bytes at offset with pread (write = 0) or pwrite (write = 1),
+// retrying partial transfers
+static void point_file_transfer(struct point_file * file, void * buffer, size_t size,
+	uint64_t offset, int write) {
+    ssize_t done;
+    while (size > 0) {
+	done = write ? pwrite(file->fd, buffer, size, (off_t) offset)
+		: pread(file->fd, buffer, size, (off_t) offset);
+	if (done <= 0) point_file_abort(write ? "Cannot write point file" : "Cannot read point file",
+		file->path);
+	buffer = (char *) buffer+done;
+	size -= done;
+	offset += done;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Create file path for n points with coordinates of coord_size bytes (4 or
+// 8); it is replaced if it exists. Points are written by point_file_write
+void point_file_create(struct point_file * file, const char * path, int n, int coord_size) {
+    memset(file, 0, sizeof(struct point_file));
+    file->path = path;
+    file->n = n;
+    file->fd = open(path, O_CREAT | O_TRUNC | O_RDWR, 0644);
+    if (file->fd < 0) point_file_abort("Cannot create point file", path);
+    memcpy(file->header.magic, POINT_FILE_MAGIC, 8);
+    file->header.version = POINT_FILE_VERSION;
+    file->header.coord_size = coord_size;
+    file->header.n = n;
+    file->header.x_offset = point_file_align(sizeof(struct point_file_header));
+    file->header.y_offset = point_file_align(file->header.x_offset+(uint64_t) n*coord_size);
+    point_file_transfer(file, &file->header, sizeof(struct point_file_header), 0, 1);
+    if (ftruncate(file->fd, (off_t) (file->header.y_offset+(uint64_t) n*coord_size)) != 0) {
+	point_file_abort("Cannot write point file", path);
+    }
+}
+
+// Write points first ... first+count-1; X and Y have the coordinate type of
+// the file
+void point_file_write(struct point_file * file, int first, const void * X, const void * Y,
+	int count) {
+    uint64_t size = file->header.coord_size;
+    point_file_transfer(file, (void *) X, count*size, file->header.x_offset+first*size, 1);
+    point_file_transfer(file, (void *) Y, count*size, file->header.y_offset+first*size, 1);
+}
+
+// Open file path for reading and check its header: magic, version,
+// coordinate size, sizes and aligned, non-overlapping arrays
+void point_file_open(struct point_file * file, const char * path) {
+    struct stat st;
+    memset(file, 0, sizeof(struct point_file));
+    file->path = path;
+    file->fd = open(path, O_RDONLY);
+    if (file->fd < 0) point_file_abort("Cannot open point file", path);
+    if ((fstat(file->fd, &st) != 0) || (st.st_size < (off_t) sizeof(struct point_file_header))) {
+	point_file_abort("Not a point file:", path);
+    }
+    point_file_transfer(file, &file->header, sizeof(struct point_file_header), 0, 0);
+    if ((memcmp(file->header.magic, POINT_FILE_MAGIC, 8) != 0)
+	    || (file->header.version != POINT_FILE_VERSION)
+	    || ((file->header.coord_size != sizeof(float)) && (file->header.coord_size != sizeof(double)))
+	    || (file->header.n > 0x7fffffff)
+	    || (file->header.x_offset < sizeof(struct point_file_header))
+	    || (file->header.x_offset % POINT_FILE_ALIGN != 0)
+	    || (file->header.y_offset % POINT_FILE_ALIGN != 0)
+	    || ((uint64_t) st.st_size < file->header.y_offset+file->header.n*file->header.coord_size)
+	    || (file->header.x_offset+file->header.n*file->header.coord_size > file->header.y_offset)) {
+	point_file_abort("Not a point file:", path);
+    }
+    file->n = (int) file->header.n;
+}
+
+void point_file_close(struct point_file * file) {
+    if (file->map != NULL) munmap(file->map, file->map_size);
+    close(file->fd);
+    file->map = NULL;
+}
+
+// ----------------------------------------------------------------------------
+// Write n float points to a new file path
+void point_file_save(const char * path, const float * X, const float * Y, int n) {
+    struct point_file file;
+    point_file_create(&file, path, n, sizeof(float));
+    point_file_write(&file, 0, X, Y, n);
+    point_file_close(&file);
+}
+
+// Write n double points to a new file path
+void point_file_save_double(const char * path, const double * X, const double * Y, int n) {
+    struct point_file file;
+    point_file_create(&file, path, n, sizeof(double));
+    point_file_write(&file, 0, X, Y, n);
+    point_file_close(&file);
+}
+
+// Read points first ... first+count-1 as floats; double coordinates are
+// read POINT_FILE_CHUNK points at a time and rounded
+void point_file_read(struct point_file * file, int first, float * X, float * Y, int count) {
+    uint64_t offset;
+    double * buffer;
+    int i, c, chunk;
+    if (file->header.coord_size == sizeof(float)) {
+	point_file_transfer(file, X, count*sizeof(float), file->header.x_offset+first*sizeof(float), 0);
+	point_file_transfer(file, Y, count*sizeof(float), file->header.y_offset+first*sizeof(float), 0);
+	return;
+    }
+    buffer = (double *) malloc(((count < POINT_FILE_CHUNK) ? count : POINT_FILE_CHUNK)*sizeof(double));
+    for (c = 0; c < count; c += chunk) {
+	chunk = (count-c < POINT_FILE_CHUNK) ? count-c : POINT_FILE_CHUNK;
+	offset = (uint64_t) (first+c)*sizeof(double);
+	point_file_transfer(file, buffer, chunk*sizeof(double), file->header.x_offset+offset, 0);
+	for (i = 0; i < chunk; i++) X[c+i] = (float) buffer[i];
+	point_file_transfer(file, buffer, chunk*sizeof(double), file->header.y_offset+offset, 0);
+	for (i = 0; i < chunk; i++) Y[c+i] = (float) buffer[i];
+    }
+    free(buffer);
+}
+
+// Map whole file read-only; the coordinate arrays of its type point into
+// the map
+void point_file_map(struct point_file * file) {
+    uint64_t size = file->header.coord_size;
+    file->map_size = (size_t) (file->header.y_offset+file->header.n*size);
+    file->map = mmap(NULL, file->map_size, PROT_READ, MAP_PRIVATE, file->fd, 0);
+    if (file->map == MAP_FAILED) {
+	file->map = NULL;
+	point_file_abort("Cannot map point file", file->path);
+    }
+    if (size == sizeof(float)) {
+	file->X = (const float *) ((char *) file->map+file->header.x_offset);
+	file->Y = (const float *) ((char *) file->map+file->header.y_offset);
+    } else {
+	file->Xd = (const double *) ((char *) file->map+file->header.x_offset);
+	file->Yd = (const double *) ((char *) file->map+file->header.y_offset);
+    }
+}
+
+// Float coordinates of mapped file: in place for a float file, rounded
+// copies for a double file; returns 1 if X and Y were allocated
+int point_file_floats(struct point_file * file, float ** X, float ** Y) {
+    int i;
+    if (file->X != NULL) {
+	*X = (float *) file->X;
+	*Y = (float *) file->Y;
+	return 0;
+    }
+    *X = (float *) malloc(file->n*sizeof(float));
+    *Y = (float *) malloc(file->n*sizeof(float));
+    for (i = 0; i < file->n; i++) {
+	(*X)[i] = (float) file->Xd[i];
+	(*Y)[i] = (float) file->Yd[i];
+    }
+    return 1;
+}
+
+// Double coordinates of mapped file: in place for a double file, exact
+// copies for a float file; returns 1 if X and Y were allocated
+int point_file_doubles(struct point_file * file, double ** X, double ** Y) {
+    int i;
+    if (file->Xd != NULL) {
+	*X = (double *) file->Xd;
+	*Y = (double *) file->Yd;
+	return 0;
+    }
+    *X = (double *) malloc(file->n*sizeof(double));
+    *Y = (double *) malloc(file->n*sizeof(double));
+    for (i = 0; i < file->n; i++) {
+	(*X)[i] = file->X[i];
+	(*Y)[i] = file->Y[i];
+    }
+    return 1;
+}
+
+// 1 if command line argument arg is a point file path rather than a number
+int point_file_arg(const char * arg) {
+    return (arg[0] == '\0') || (strspn(arg, "0123456789") != strlen(arg));
+}
+
+#endif
@@ -0,0 +1,158 @@
+// ----------------------------------------------------------------------------
+// Nearest-neighbor and radius queries on n points
+//
+// The points are initialized as in nbody.cu (uniform in a sqrt(n) x
+// sqrt(n) square), or read from a point file (point_io.h), which is
+// mapped and used in place. A grid index of the points (point_grid.h) is built
+// once; then the k nearest neighbors of every point, and all pairs of
+// points within a radius, are found on it (point_grid_query.h). For up to
+// MAX_CHECK_POINTS points, the results are checked by brute force.
+//
+// Compilation command:
+//
+//   gcc -O3 -fopenmp-simd -fno-math-errno -march=native -o point_queries.exe point_queries.c -lpthread -lm
+//
+// Sample execution:
+//
+//   ./point_queries.exe 1048576 8 0.5 4
+//   ./point_queries.exe points.bin 8 0.5 4
+//
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "point_grid_query.h"
+#include "point_io.h"
+#include "../common/timing.h"
+
+#define MAX_POINTS 268435456
+#define MAX_CHECK_POINTS 16384
+
+// ----------------------------------------------------------------------------
+// Elapsed time in ms since start
+double elapsed_ms(struct timespec * start) {
+    struct timespec stop;
+    timing_read(&stop);
+    return 1000*timing_elapsed(start, &stop);
+}
+
+// Check k nearest neighbor distances and number of pairs within radius by
+// brute force; returns number of errors
+int check_queries(float * X, float * Y, int n, int k, float * dist, float radius,
+	long long num_pairs) {
+    float * d2 = (float *) malloc(k*sizeof(float));
+    int * nbr = (int *) malloc(k*sizeof(int));
+    long long pairs = 0;
+    float dx, dy, D;
+    int i, j, m, found, errors = 0;
+    for (i = 0; i < n; i++) {
+	found = 0;
+	for (j = 0; j < n; j++) {
+	    if (j == i) continue;
+	    dx = X[j]-X[i];
+	    dy = Y[j]-Y[i];
+	    found = knn_insert(nbr, d2, found, k, j, dx*dx+dy*dy);
+	    if ((j > i) && (dx*dx+dy*dy <= radius*radius)) pairs++;
+	}
+	for (m = 0; m < k; m++) {
+	    D = (m < found) ? sqrtf(d2[m]) : FLT_MAX;
+	    if (D != dist[(long long) i*k+m]) errors++;
+	}
+    }
+    if (pairs != num_pairs) errors++;
+    free(d2); free(nbr);
+    return errors;
+}
+
+// ----------------------------------------------------------------------------
+// Main program - initializes points, builds grid index and runs queries
+//
+int main(int argc, char * argv[]) {
+    float * X, * Y;			// Coordinates of the points
+    int * nbr;				// k nearest neighbors of each point
+    float * dist;			// Distances to the neighbors
+    int * pairs = NULL;			// Pairs of points within radius
+    long long num_pairs, capacity = 0;
+    struct point_grid grid;
+    struct point_file points;		// Mapped point file
+    int from_file, own_points = 1;
+    struct timespec start;
+    double build_time, knn_time, radius_time;
+    float radius, sqrtn, mean_nn = 0.0f;
+    int num_points, k, num_threads, i, errors;
+
+    if ((argc != 4) && (argc != 5)) {
+	printf("Use: %s <number of points | point file> <k> <radius> [<number of threads>]\n", argv[0]);
+	exit(0);
+    }
+    from_file = point_file_arg(argv[1]);
+    if (from_file) {
+	point_file_open(&points, argv[1]);
+	point_file_map(&points);
+	num_points = points.n;
+    } else {
+	num_points = atoi(argv[1]);
+    }
+    k = atoi(argv[2]);
+    radius = (float) atof(argv[3]);
+    num_threads = (argc == 5) ? atoi(argv[4]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if ((num_points < 2) || (num_points > MAX_POINTS)) {
+	printf("Number of points outside range [%d ... %d]. Aborting ...\n", 2, MAX_POINTS);
+	exit(0);
+    }
+    if (k < 1) {
+	printf("k must be at least 1. Aborting ...\n");
+	exit(0);
+    }
+
+    // Initialize points
+    nbr = (int *) malloc((long long) num_points*k*sizeof(int));
+    dist = (float *) malloc((long long) num_points*k*sizeof(float));
+    if (from_file) {
+	own_points = point_file_floats(&points, &X, &Y);
+    } else {
+	X = (float *) malloc(num_points*sizeof(float));
+	Y = (float *) malloc(num_points*sizeof(float));
+	srand48(0);
+	sqrtn = (float) sqrt(num_points);
+	for (i = 0; i < num_points; i++) {
+	    X[i] = sqrtn * (float)drand48();
+	    Y[i] = sqrtn * (float)drand48();
+	}
+    }
+
+    timing_read(&start);
+    point_grid_build(&grid, X, Y, num_points, 0.0f, num_threads);
+    build_time = elapsed_ms(&start);
+
+    timing_read(&start);
+    point_grid_all_knn(&grid, k, nbr, dist, num_threads);
+    knn_time = elapsed_ms(&start);
+
+    timing_read(&start);
+    num_pairs = point_grid_pairs_within(&grid, radius, &pairs, &capacity, num_threads);
+    radius_time = elapsed_ms(&start);
+
+    for (i = 0; i < num_points; i++) {
+	mean_nn += dist[(long long) i*k];
+    }
+    mean_nn /= num_points;
+    printf("Number of points = %d, threads = %d, build time = %f ms, %d-NN time = %f ms, pairs within %g = %lld, radius time = %f ms, mean NN distance = %e\n",
+	    num_points, num_threads, build_time, k, knn_time, radius, num_pairs, radius_time, mean_nn);
+
+    if (num_points <= MAX_CHECK_POINTS) {
+	errors = check_queries(X, Y, num_points, k, dist, radius, num_pairs);
+	if (errors > 0) {
+	    printf("Error encountered. %d query results differ from brute force.\n", errors);
+	}
+    }
+
+    point_grid_free(&grid);
+    if (own_points) {
+	free(X); free(Y);
+    }
+    if (from_file) point_file_close(&points);
+    free(nbr); free(dist); free(pairs);
+}
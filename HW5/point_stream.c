@@ -0,0 +1,125 @@
+// ----------------------------------------------------------------------------
+// Closest pair of a stream of points, maintained incrementally
+//
+// n points, initialized as in nbody.cu (uniform in a sqrt(n) x sqrt(n)
+// square) or read from a point file (point_io.h), arrive in batches of
+// batch_size points; batches of a file are read as they arrive. After each batch, the
+// closest pair so far is updated by point_stream_insert (point_stream.h),
+// which only checks the cells around the new points. At the end, the
+// minimum distance is checked against the grid computation on all points
+// (point_grid.h).
+//
+// Compilation command:
+//
+//   gcc -O3 -fopenmp-simd -fno-math-errno -march=native -o point_stream.exe point_stream.c -lpthread -lm
+//
+// Sample execution:
+//
+//   ./point_stream.exe 1048576 1024
+//   ./point_stream.exe points.bin 1024
+//
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "point_stream.h"
+#include "point_grid.h"
+#include "point_io.h"
+#include "../common/timing.h"
+
+#define MAX_POINTS 268435456
+
+#ifndef VERBOSE
+#define VERBOSE 0			// Use VERBOSE to control output
+#endif
+
+// ----------------------------------------------------------------------------
+// Main program - streams points in batches and maintains the closest pair
+//
+int main(int argc, char * argv[]) {
+    float * X, * Y;			// Coordinates of the points
+    struct point_stream stream;
+    struct point_file points;		// Point file, read a batch at a time
+    int from_file;
+    struct timespec start, stop;
+    double batch_time, total_time = 0.0, max_batch_time = 0.0;
+    float sqrtn, min_distance;
+    int num_points, batch_size, num_batches, first, count, i;
+
+    if (argc != 3) {
+	printf("Use: %s <number of points | point file> <batch size>\n", argv[0]);
+	exit(0);
+    }
+    from_file = point_file_arg(argv[1]);
+    if (from_file) {
+	point_file_open(&points, argv[1]);
+	num_points = points.n;
+    } else {
+	num_points = atoi(argv[1]);
+    }
+    batch_size = atoi(argv[2]);
+    if ((num_points < 2) || (num_points > MAX_POINTS)) {
+	printf("Number of points outside range [%d ... %d]. Aborting ...\n", 2, MAX_POINTS);
+	exit(0);
+    }
+    if (batch_size < 1) {
+	printf("Batch size must be at least 1. Aborting ...\n");
+	exit(0);
+    }
+
+    // Initialize points; they are inserted in batches below. Points of a
+    // file are read into the first batch_size entries, a batch at a time
+    if (from_file) {
+	X = (float *) malloc(batch_size*sizeof(float));
+	Y = (float *) malloc(batch_size*sizeof(float));
+    } else {
+	X = (float *) malloc(num_points*sizeof(float));
+	Y = (float *) malloc(num_points*sizeof(float));
+	srand48(0);
+	sqrtn = (float) sqrt(num_points);
+	for (i = 0; i < num_points; i++) {
+	    X[i] = sqrtn * (float)drand48();
+	    Y[i] = sqrtn * (float)drand48();
+	}
+    }
+
+    point_stream_init(&stream);
+    num_batches = 0;
+    for (first = 0; first < num_points; first += batch_size) {
+	count = (num_points-first < batch_size) ? num_points-first : batch_size;
+	if (from_file) point_file_read(&points, first, X, Y, count);
+	timing_read(&start);
+
+	if (from_file) {
+	    point_stream_insert(&stream, X, Y, count);
+	} else {
+	    point_stream_insert(&stream, &X[first], &Y[first], count);
+	}
+
+	timing_read(&stop);
+	batch_time = 1000*timing_elapsed(&start, &stop);
+	total_time += batch_time;
+	if (batch_time > max_batch_time) max_batch_time = batch_time;
+	num_batches++;
+	if (VERBOSE > 0) {
+	    printf("Batch %d: points = %d, min. distance = %e (%d, %d), time = %f ms\n", num_batches,
+		    stream.n, point_stream_min_distance(&stream), stream.min_i, stream.min_j, batch_time);
+	}
+    }
+
+    printf("Number of points = %d, batch size = %d, batches = %d, rebuilds = %d, total time = %f ms, mean batch time = %f ms, max batch time = %f ms, min. distance = %e\n",
+	    num_points, batch_size, num_batches, stream.rebuilds, total_time, total_time/num_batches,
+	    max_batch_time, point_stream_min_distance(&stream));
+
+    // Check against minimum distance of all points (the stream holds them,
+    // in insertion order)
+    min_distance = minimum_distance_grid(stream.X, stream.Y, num_points, 1);
+    if (min_distance != point_stream_min_distance(&stream)) {
+	printf("Error encountered. Minimum distance of all points = %e.\n", min_distance);
+    }
+
+    point_stream_free(&stream);
+    if (from_file) point_file_close(&points);
+    free(X); free(Y);
+}
@@ -0,0 +1,217 @@
+// ----------------------------------------------------------------------------
+// Header file with an incremental closest-pair structure for a stream of
+// points
+//
+// Points are inserted in batches into a hashed grid: cells of side
+// cell_size, keyed by their (unbounded) integer coordinates in an open
+// addressing hash table; the points of a cell are a linked list. The
+// grid keeps cell_size >= d, the current minimum distance, so a new point
+// closer than d to some point lies in one of the 3 x 3 cells around it,
+// and only those cells are checked. As no two points are closer than d,
+// a cell of side cell_size < 2d holds a bounded number of points, and an
+// insertion costs O(1) expected time.
+//
+// When d drops below cell_size/2, the grid is rebuilt with cell_size = d.
+// A rebuild costs O(n), but for points from a fixed distribution d
+// shrinks geometrically as n grows, so rebuilds are rare and the cost of
+// a batch is proportional to its size, amortized over the stream. Once
+// d = 0 (duplicate points) it cannot decrease further, and points are
+// only appended.
+//
+// Contains following routines
+//
+//    point_stream_init(&stream)
+//	- initialize an empty stream
+//
+//    point_stream_insert(&stream, X, Y, count)
+//	- insert a batch of points and update the closest pair
+//
+//    point_stream_min_distance(&stream)
+//	- distance between the closest pair so far
+//
+//    point_stream_free(&stream)
+//	- free stream arrays
+//
+#ifndef POINT_STREAM_H
+#define POINT_STREAM_H
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STREAM_INITIAL_CAPACITY	1024	// Initial no. of points and cells
+
+struct point_stream_cell {
+    long long cx, cy;			// Cell coordinates
+    int head;				// First point of cell; -1 if slot is empty
+};
+
+struct point_stream {
+    int n, capacity;			// Number of points and size of arrays
+    float * X, * Y;			// Coordinates of the points, in insertion order
+    int * next;				// Next point in the same cell; -1 at the end
+    float cell_size;			// Side of a cell; 0 until there is a grid
+    struct point_stream_cell * cells;	// Hash table of cells
+    int num_cells, table_size;		// Occupied slots and size (power of 2)
+    float min_distance2;		// Squared distance of closest pair
+    int min_i, min_j;			// Closest pair (insertion indices); -1 if none
+    int rebuilds;			// Number of grid rebuilds
+};
+
+// ----------------------------------------------------------------------------
+// Slot of cell (cx, cy) in the hash table: the cell, or the empty slot
+// where it would go
+static inline int point_stream_slot(const struct point_stream * stream, long long cx,
+	long long cy) {
+    uint64_t h = (uint64_t) cx*0x9e3779b97f4a7c15ULL ^ (uint64_t) cy*0xc2b2ae3d27d4eb4fULL;
+    int slot = (int) ((h ^ (h >> 29)) & (uint64_t) (stream->table_size-1));
+    while ((stream->cells[slot].head >= 0) &&
+	    ((stream->cells[slot].cx != cx) || (stream->cells[slot].cy != cy))) {
+	slot = (slot+1) & (stream->table_size-1);
+    }
+    return slot;
+}
+
+static inline long long point_stream_coord(float v, float cell_size) {
+    return (long long) floorf(v/cell_size);
+}
+
+// Empty hash table with table_size slots
+static void point_stream_clear_cells(struct point_stream * stream, int table_size) {
+    int slot;
+    if (table_size != stream->table_size) {
+	free(stream->cells);
+	stream->cells = (struct point_stream_cell *) malloc(table_size*sizeof(struct point_stream_cell));
+	stream->table_size = table_size;
+    }
+    for (slot = 0; slot < table_size; slot++) {
+	stream->cells[slot].head = -1;
+    }
+    stream->num_cells = 0;
+}
+
+// Add point i to the list of its cell
+static void point_stream_add_to_cell(struct point_stream * stream, int i) {
+    long long cx = point_stream_coord(stream->X[i], stream->cell_size);
+    long long cy = point_stream_coord(stream->Y[i], stream->cell_size);
+    int slot = point_stream_slot(stream, cx, cy);
+    if (stream->cells[slot].head < 0) {
+	stream->cells[slot].cx = cx;
+	stream->cells[slot].cy = cy;
+	stream->num_cells++;
+    }
+    stream->next[i] = stream->cells[slot].head;
+    stream->cells[slot].head = i;
+}
+
+// Rebuild grid of points 0 ... n-1 with cells of side cell_size; the table
+// is kept at most half full
+static void point_stream_rebuild(struct point_stream * stream, float cell_size) {
+    int table_size = STREAM_INITIAL_CAPACITY, i;
+    while (table_size < 2*stream->n) table_size *= 2;
+    stream->cell_size = cell_size;
+    point_stream_clear_cells(stream, table_size);
+    for (i = 0; i < stream->n; i++) {
+	point_stream_add_to_cell(stream, i);
+    }
+    stream->rebuilds++;
+}
+
+// Check point i against the points in the 3 x 3 cells around it
+static void point_stream_check_neighbors(struct point_stream * stream, int i) {
+    long long cx = point_stream_coord(stream->X[i], stream->cell_size);
+    long long cy = point_stream_coord(stream->Y[i], stream->cell_size);
+    float dx, dy, D2ij;
+    long long x, y;
+    int j;
+    for (y = cy-1; y <= cy+1; y++) {
+	for (x = cx-1; x <= cx+1; x++) {
+	    for (j = stream->cells[point_stream_slot(stream, x, y)].head; j >= 0; j = stream->next[j]) {
+		dx = stream->X[j]-stream->X[i];
+		dy = stream->Y[j]-stream->Y[i];
+		D2ij = dx*dx+dy*dy;
+		if (D2ij < stream->min_distance2) {
+		    stream->min_distance2 = D2ij;
+		    stream->min_i = j;
+		    stream->min_j = i;
+		}
+	    }
+	}
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Initialize an empty stream
+void point_stream_init(struct point_stream * stream) {
+    memset(stream, 0, sizeof(struct point_stream));
+    stream->min_distance2 = FLT_MAX;
+    stream->min_i = stream->min_j = -1;
+}
+
+// Insert a batch of points and update the closest pair
+// Input:
+//	X: X[i] = x-coordinate of the ith point of the batch
+//	Y: Y[i] = y-coordinate of the ith point of the batch
+//	count: number of points in the batch
+// Output:
+//	stream: points are appended (point stream->n+i is the ith point
+//		of the batch) and the closest pair is updated
+//
+void point_stream_insert(struct point_stream * stream, const float * X, const float * Y,
+	int count) {
+    float dx, dy;
+    int b, i;
+
+    if (stream->n+count > stream->capacity) {
+	if (stream->capacity == 0) stream->capacity = STREAM_INITIAL_CAPACITY;
+	while (stream->n+count > stream->capacity) stream->capacity *= 2;
+	stream->X = (float *) realloc(stream->X, stream->capacity*sizeof(float));
+	stream->Y = (float *) realloc(stream->Y, stream->capacity*sizeof(float));
+	stream->next = (int *) realloc(stream->next, stream->capacity*sizeof(int));
+    }
+
+    for (b = 0; b < count; b++) {
+	i = stream->n++;
+	stream->X[i] = X[b];
+	stream->Y[i] = Y[b];
+	if (stream->min_distance2 == 0.0f) continue;	// Cannot decrease further
+
+	if (stream->cell_size == 0.0f) {
+	    // No grid until the first pair
+	    if (i == 1) {
+		dx = stream->X[1]-stream->X[0];
+		dy = stream->Y[1]-stream->Y[0];
+		stream->min_distance2 = dx*dx+dy*dy;
+		stream->min_i = 0; stream->min_j = 1;
+		if (stream->min_distance2 > 0.0f) point_stream_rebuild(stream, sqrtf(stream->min_distance2));
+	    }
+	    continue;
+	}
+
+	point_stream_check_neighbors(stream, i);
+	if (4.0f*stream->min_distance2 < stream->cell_size*stream->cell_size) {
+	    // Closest pair is much closer than the cell size: smaller cells
+	    if (stream->min_distance2 > 0.0f) point_stream_rebuild(stream, sqrtf(stream->min_distance2));
+	} else {
+	    if (2*(stream->num_cells+1) > stream->table_size) {
+		point_stream_rebuild(stream, stream->cell_size);
+	    } else {
+		point_stream_add_to_cell(stream, i);
+	    }
+	}
+    }
+}
+
+// Distance between the closest pair so far (FLT_MAX if fewer than 2 points)
+float point_stream_min_distance(const struct point_stream * stream) {
+    return (stream->min_distance2 < FLT_MAX) ? sqrtf(stream->min_distance2) : FLT_MAX;
+}
+
+// Free stream arrays
+void point_stream_free(struct point_stream * stream) {
+    free(stream->X); free(stream->Y); free(stream->next); free(stream->cells);
+}
+
+#endif
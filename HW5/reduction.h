@@ -0,0 +1,103 @@
+// ----------------------------------------------------------------------------
+// Header file with a portable two-level minimum reduction
+//
+//   1. block level - the values of a block of threads (a shared memory
+//	array) are reduced by a tree with sequential addressing: in step s,
+//	value t is combined with value t+s for t < s, so active threads
+//	are contiguous and shared memory accesses are conflict free. The
+//	barrier of each step is outside any branch, so every thread of
+//	the block reaches it.
+//   2. grid level - one thread per block combines the block minimum into
+//	the result with a compare-and-swap loop (lock-free). There is no
+//	block counter, so nothing has to be reset between launches except
+//	the result itself, which is set to REDUCTION_MIN_IDENTITY before
+//	each reduction.
+//
+// The same routines compile for the host (without nvcc, or in host code):
+// the block tree then runs its steps over an array, and the combine uses
+// a CPU atomic compare-and-swap, so the reduction can be used by CPU
+// threads and tested without a GPU (reduction_check.c).
+//
+// Contains following routines
+//
+//    reduce_min_block(values, count)		(device)
+//	- minimum of values[0 ... count-1] in shared memory; called by all
+//	  threads of the block, count <= blockDim.x
+//
+//    reduce_min_block_host(values, count)	(host)
+//	- minimum of values[0 ... count-1], by the same tree
+//
+//    reduce_min_combine(&result, value)	(host and device)
+//	- result = min(result, value), atomically
+//
+#ifndef REDUCTION_H
+#define REDUCTION_H
+
+#include <float.h>
+
+#define REDUCTION_MIN_IDENTITY	FLT_MAX	// Initial value of a minimum
+
+#ifdef __CUDACC__
+#define REDUCTION_HD	__host__ __device__
+#else
+#define REDUCTION_HD
+#endif
+
+// Smallest power of 2 that is at least count, divided by 2: first stride
+// of the tree
+static inline REDUCTION_HD int reduce_first_stride(int count) {
+    int s = 1;
+    while (s < count) s *= 2;
+    return s/2;
+}
+
+#ifdef __CUDACC__
+// ----------------------------------------------------------------------------
+// Minimum of values[0 ... count-1] (shared memory) for all threads of the
+// block; values is overwritten
+__device__ float reduce_min_block(float * values, int count) {
+    int s, t = threadIdx.x;
+    __syncthreads();
+    for (s = reduce_first_stride(count); s > 0; s /= 2) {
+	if ((t < s) && (t+s < count) && (values[t+s] < values[t])) {
+	    values[t] = values[t+s];
+	}
+	__syncthreads();
+    }
+    return values[0];
+}
+#endif
+
+// Minimum of values[0 ... count-1]; values is overwritten. Step s of the
+// tree is the work of threads t < s in reduce_min_block
+float reduce_min_block_host(float * values, int count) {
+    int s, t;
+    if (count <= 0) return REDUCTION_MIN_IDENTITY;
+    for (s = reduce_first_stride(count); s > 0; s /= 2) {
+	for (t = 0; (t < s) && (t+s < count); t++) {
+	    if (values[t+s] < values[t]) values[t] = values[t+s];
+	}
+    }
+    return values[0];
+}
+
+// ----------------------------------------------------------------------------
+// result = min(result, value), atomically: retry the compare-and-swap
+// until it succeeds or result is already not larger than value
+static inline REDUCTION_HD void reduce_min_combine(float * result, float value) {
+#ifdef __CUDA_ARCH__
+    int old = __float_as_int(*result), assumed;
+    while (value < __int_as_float(old)) {
+	assumed = old;
+	old = atomicCAS((int *) result, assumed, __float_as_int(value));
+	if (old == assumed) break;
+    }
+#else
+    float old;
+    __atomic_load(result, &old, __ATOMIC_RELAXED);
+    while ((value < old) &&
+	    !__atomic_compare_exchange(result, &old, &value, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+#endif
+}
+
+#endif
@@ -0,0 +1,164 @@
+// ----------------------------------------------------------------------------
+// Check the minimum reduction of reduction.h on the host
+//
+// The kernel of nbody.cu reduces the minima of its threads with
+// reduce_min_block, then combines the block minima with
+// reduce_min_combine. The host versions of the same routines are checked
+// against a serial minimum:
+//
+//   block level - reduce_min_block_host for every count from 0 (identity)
+//	to MAX_BLOCK_SIZE, powers of two or not, REPEATS times per count on
+//	the same buffer; for counts up to EXHAUSTIVE_COUNT, the minimum is
+//	also placed at every position, so every branch of the tree is used
+//   grid level  - num_threads threads reduce blocks of BLOCK_SIZE values
+//	with reduce_min_block_host and combine their minima into one result
+//	with reduce_min_combine; the result is reset to
+//	REDUCTION_MIN_IDENTITY and the reduction repeated, as for successive
+//	kernel launches
+//
+// Compilation command:
+//
+//   gcc -O3 -o reduction_check.exe reduction_check.c -lpthread
+//
+// Sample execution:
+//
+//   ./reduction_check.exe 8
+//
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "reduction.h"
+
+#define MAX_BLOCK_SIZE		1025	// Largest count of block reductions
+#define EXHAUSTIVE_COUNT	64	// Minimum at every position up to this count
+#define REPEATS			8	// Reductions per count, or of the grid
+#define BLOCK_SIZE		256	// Values per block of grid reductions
+#define NUM_BLOCKS		1000	// Blocks per grid reduction (not a power of 2)
+#define MAX_THREADS		64
+
+struct grid_job {
+    float * values;			// NUM_BLOCKS*BLOCK_SIZE values
+    float result;			// Minimum; threads combine into it
+    int next_block;			// Next block to reduce; taken atomically
+};
+
+// ----------------------------------------------------------------------------
+float serial_min(const float * values, int count) {
+    float min = REDUCTION_MIN_IDENTITY;
+    int i;
+    for (i = 0; i < count; i++) {
+	if (values[i] < min) min = values[i];
+    }
+    return min;
+}
+
+// Values in [0, 1); duplicates of the minimum are likely for small counts
+void random_values(float * values, int count) {
+    int i;
+    for (i = 0; i < count; i++) values[i] = (float) (lrand48() % 1000)/1000.0f;
+}
+
+// Check reduce_min_block_host on values[0 ... count-1]; returns 1 on error
+int check_block(float * values, float * copy, int count) {
+    float expected = serial_min(values, count), min;
+    int i;
+    for (i = 0; i < count; i++) copy[i] = values[i];	// Tree overwrites its input
+    min = reduce_min_block_host(copy, count);
+    if (min != expected) {
+	printf("Error encountered. Block minimum of %d values = %e, expected %e.\n",
+		count, min, expected);
+	return 1;
+    }
+    return 0;
+}
+
+// Block reductions: every count, repeated, and minimum at every position
+int check_blocks(int * num_checks) {
+    float values[MAX_BLOCK_SIZE], copy[MAX_BLOCK_SIZE];
+    int count, repeat, p, errors = 0;
+    if (reduce_min_block_host(values, 0) != REDUCTION_MIN_IDENTITY) {
+	printf("Error encountered. Minimum of no values is not the identity.\n");
+	errors++;
+    }
+    (*num_checks)++;
+    for (count = 1; count <= MAX_BLOCK_SIZE; count++) {
+	for (repeat = 0; repeat < REPEATS; repeat++) {
+	    random_values(values, count);
+	    errors += check_block(values, copy, count);
+	    (*num_checks)++;
+	}
+	if (count > EXHAUSTIVE_COUNT) continue;
+	for (p = 0; p < count; p++) {
+	    random_values(values, count);
+	    values[p] = -1.0f;
+	    errors += check_block(values, copy, count);
+	    (*num_checks)++;
+	}
+    }
+    return errors;
+}
+
+// ----------------------------------------------------------------------------
+// Reduce blocks until none is left, as the blocks of a kernel launch
+void * grid_thread(void * arg) {
+    struct grid_job * job = (struct grid_job *) arg;
+    float block[BLOCK_SIZE];
+    int b, i;
+    while ((b = __atomic_fetch_add(&job->next_block, 1, __ATOMIC_RELAXED)) < NUM_BLOCKS) {
+	for (i = 0; i < BLOCK_SIZE; i++) block[i] = job->values[b*BLOCK_SIZE+i];
+	reduce_min_combine(&job->result, reduce_min_block_host(block, BLOCK_SIZE));
+    }
+    return NULL;
+}
+
+// Grid reductions with num_threads threads, repeated with the result reset
+int check_grid(int num_threads, int * num_checks) {
+    struct grid_job job;
+    pthread_t threads[MAX_THREADS];
+    float expected;
+    int repeat, t, errors = 0;
+    job.values = (float *) malloc(NUM_BLOCKS*BLOCK_SIZE*sizeof(float));
+    for (repeat = 0; repeat < REPEATS; repeat++) {
+	random_values(job.values, NUM_BLOCKS*BLOCK_SIZE);
+	job.values[lrand48() % (NUM_BLOCKS*BLOCK_SIZE)] = -(float) repeat;
+	expected = serial_min(job.values, NUM_BLOCKS*BLOCK_SIZE);
+	job.result = REDUCTION_MIN_IDENTITY;
+	job.next_block = 0;
+	for (t = 1; t < num_threads; t++) {
+	    pthread_create(&threads[t], NULL, grid_thread, (void *) &job);
+	}
+	grid_thread((void *) &job);
+	for (t = 1; t < num_threads; t++) {
+	    pthread_join(threads[t], NULL);
+	}
+	if (job.result != expected) {
+	    printf("Error encountered. Grid minimum %d = %e, expected %e.\n", repeat, job.result, expected);
+	    errors++;
+	}
+	(*num_checks)++;
+    }
+    free(job.values);
+    return errors;
+}
+
+// ----------------------------------------------------------------------------
+// Main program - checks block and grid reductions
+//
+int main(int argc, char * argv[]) {
+    int num_threads, block_checks = 0, grid_checks = 0, errors;
+    if (argc > 2) {
+	printf("Use: %s [<number of threads>]\n", argv[0]);
+	exit(0);
+    }
+    num_threads = (argc == 2) ? atoi(argv[1]) : 4;
+    if ((num_threads < 1) || (num_threads > MAX_THREADS)) {
+	printf("Number of threads outside range [%d ... %d]. Aborting ...\n", 1, MAX_THREADS);
+	exit(0);
+    }
+    srand48(0);
+    errors = check_blocks(&block_checks);
+    errors += check_grid(num_threads, &grid_checks);
+    printf("Block reductions = %d, grid reductions = %d (threads = %d), errors = %d\n",
+	    block_checks, grid_checks, num_threads, errors);
+    return (errors == 0) ? 0 : 1;
+}
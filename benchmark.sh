@@ -0,0 +1,267 @@
+#!/bin/bash
+# -----------------------------------------------------------------------------
+# Benchmark driver for the kernels of all assignments
+#
+# Builds the selected kernels, then sweeps problem sizes, thread counts and
+# (for MPI kernels) process counts. Every configuration is run WARMUP times
+# untimed and RUNS times timed; the time each program reports is taken
+# from its output line. One CSV line per configuration is written, with
+# the median, minimum and standard deviation of the timed runs, and the
+# speedup and parallel efficiency relative to the first (smallest) worker
+# count of the sweep (workers = processes x threads):
+#
+#   strong scaling - the total problem size is fixed:
+#	speedup = w0*T(w0)/T(w), efficiency = speedup/w
+#   weak scaling   - the problem size per worker is fixed (size x w):
+#	speedup = w*T(w0)/T(w) (scaled), efficiency = T(w0)/T(w)
+#
+# A scaling table per kernel, mode and size is printed to stderr.
+#
+# Kernels (default: all except qsort_hypercube when mpicc is missing):
+#
+#   compute_pi		HW1/compute_pi.c	<trials> <threads>
+#   list_minimum		HW2/list_minimum.c	<list size> <threads>
+#   list_statistics	HW2/list_statistics.c	<list size> <threads>
+#   drone		HW3/drone.c		<grid size> ... (one thread per row,
+#						so only sizes are swept)
+#   qsort_hypercube	HW4/qsort_hypercube.c	mpirun -np <processes> ...
+#						<list size/process> 0 <threads>
+#   min_distance		HW5/min_distance.c	<points> <threads>
+#
+# Use: ./benchmark.sh [options] [kernel ...]
+#
+#   -t list	thread counts, e.g. 1,2,4,8 (default 1,2,4,8)
+#   -p list	process counts of MPI kernels (default 1,2,4)
+#   -n list	problem sizes (default: per kernel, see default_sizes)
+#   -m list	scaling modes: strong, weak or strong,weak (default strong,weak)
+#   -w count	warm-up runs per configuration (default 1)
+#   -r count	timed runs per configuration (default 5)
+#   -o file	CSV output file (default: standard output)
+#   -b dir	build directory (default bench_build)
+#   -q		no scaling tables
+#
+# Environment: CC (default gcc), MPICC (default mpicc), MPIRUN (default
+# mpirun), DRONE_ARGS (seed, delay in ns and move count of drone; default
+# "0 0 0").
+#
+# Sample execution:
+#
+#   ./benchmark.sh -t 1,2,4 -r 3 -o results.csv compute_pi min_distance
+#
+ROOT=$(cd "$(dirname "$0")" && pwd)
+CC=${CC:-gcc}
+MPICC=${MPICC:-mpicc}
+MPIRUN=${MPIRUN:-mpirun}
+DRONE_ARGS=${DRONE_ARGS:-"0 0 0"}
+
+THREADS=1,2,4,8
+PROCS=1,2,4
+SIZES=
+MODES=strong,weak
+WARMUP=1
+RUNS=5
+OUTPUT=
+BUILD=bench_build
+TABLES=1
+
+usage() {
+    sed -n '/^# Use:/,/^# Sample/p' "$0" | sed '$d; s/^# \{0,1\}//'
+    exit 1
+}
+
+# -----------------------------------------------------------------------------
+# Kernel definitions
+
+default_sizes() {
+    case $1 in
+	compute_pi)		echo 10000000,100000000 ;;
+	list_minimum)		echo 20000000 ;;
+	list_statistics)	echo 20000000 ;;
+	drone)			echo 64,256,1024 ;;
+	qsort_hypercube)	echo 4194304 ;;
+	min_distance)		echo 1048576,16777216 ;;
+    esac
+}
+
+# Build kernel $1 into $BUILD/$1.exe
+build() {
+    local exe=$BUILD/$1.exe
+    case $1 in
+	compute_pi)	 $CC -O3 -o $exe "$ROOT/HW1/compute_pi.c" -lpthread -lm ;;
+	list_minimum)	 $CC -O3 -o $exe "$ROOT/HW2/list_minimum.c" -lpthread -lrt ;;
+	list_statistics) $CC -O3 -o $exe "$ROOT/HW2/list_statistics.c" -lpthread -lrt -lm ;;
+	drone)		 $CC -O3 -o $exe "$ROOT/HW3/drone.c" -lpthread -lrt ;;
+	qsort_hypercube) $MPICC -O3 -o $exe "$ROOT/HW4/qsort_hypercube.c" -lpthread -lm ;;
+	min_distance)	 $CC -O3 -fopenmp-simd -fno-math-errno -march=native -o $exe \
+			     "$ROOT/HW5/min_distance.c" -lpthread -lm ;;
+	*)		 echo "Unknown kernel $1" >&2; return 1 ;;
+    esac
+}
+
+# Command line of kernel $1 for size $2, $3 threads and $4 processes
+command_line() {
+    local exe=$BUILD/$1.exe
+    case $1 in
+	drone)		 echo "$exe $2 $DRONE_ARGS" ;;
+	qsort_hypercube) echo "$MPIRUN -np $4 $exe $2 0 $3" ;;
+	*)		 echo "$exe $2 $3" ;;
+    esac
+}
+
+# Time in seconds reported in the output (stdin) of kernel $1; the largest
+# if several lines report one. Empty if none is found
+parse_time() {
+    local pattern="time (sec) ="
+    [ "$1" = qsort_hypercube ] && pattern="hypercube quicksort time ="
+    awk -v pattern="$pattern" '
+	(k = index($0, pattern)) > 0 {
+	    t = substr($0, k+length(pattern))+0
+	    if (!found || t > max) max = t
+	    found = 1
+	}
+	END { if (found) printf "%.9e\n", max }'
+}
+
+# -----------------------------------------------------------------------------
+# Run configuration (kernel $1, size $2, $3 threads, $4 processes); prints
+# "median min stddev" of the timed runs, nothing if a run fails
+measure() {
+    local cmd t i times=
+    cmd=$(command_line "$@")
+    for ((i = 0; i < WARMUP; i++)); do
+	$cmd > /dev/null 2>&1
+    done
+    for ((i = 0; i < RUNS; i++)); do
+	t=$($cmd 2>&1 | parse_time $1)
+	if [ -z "$t" ]; then
+	    echo "No time reported by: $cmd" >&2
+	    return
+	fi
+	times="$times $t"
+    done
+    echo $times | tr ' ' '\n' | sort -g | awk '
+	{ t[NR] = $1; sum += $1 }
+	END {
+	    median = (NR % 2) ? t[(NR+1)/2] : (t[NR/2]+t[NR/2+1])/2
+	    mean = sum/NR
+	    for (i = 1; i <= NR; i++) ss += (t[i]-mean)^2
+	    printf "%.6e %.6e %.6e\n", median, t[1], (NR > 1) ? sqrt(ss/(NR-1)) : 0
+	}'
+}
+
+# Sweep kernel $1; prints CSV lines
+sweep() {
+    local kernel=$1 sizes procs threads mode size p t workers w0 t0 total arg stats
+    local median min stddev speedup efficiency
+    sizes=${SIZES:-$(default_sizes $kernel)}
+    procs=1
+    [ $kernel = qsort_hypercube ] && procs=$PROCS
+
+    if [ $kernel = drone ]; then
+	# One thread per row of the grid: threads follow the size
+	for size in ${sizes//,/ }; do
+	    echo "  $kernel size $size" >&2
+	    stats=$(measure $kernel $size $size 1)
+	    [ -z "$stats" ] && continue
+	    read median min stddev <<< "$stats"
+	    echo "$kernel,size,$size,$size,1,$size,$size,$RUNS,$median,$min,$stddev,,"
+	done
+	return
+    fi
+
+    for mode in ${MODES//,/ }; do
+	for size in ${sizes//,/ }; do
+	    w0=; t0=
+	    for p in ${procs//,/ }; do
+		for t in ${THREADS//,/ }; do
+		    workers=$((p*t))
+		    # Total problem size; qsort_hypercube takes the size per process
+		    if [ $mode = weak ]; then
+			total=$((size*workers))
+		    else
+			total=$size
+		    fi
+		    arg=$total
+		    [ $kernel = qsort_hypercube ] && arg=$((total/p))
+		    echo "  $kernel $mode size $total processes $p threads $t" >&2
+		    stats=$(measure $kernel $arg $t $p)
+		    [ -z "$stats" ] && continue
+		    read median min stddev <<< "$stats"
+		    if [ -z "$w0" ]; then
+			w0=$workers; t0=$median
+		    fi
+		    read speedup efficiency <<< $(awk -v mode=$mode -v w0=$w0 -v t0=$t0 \
+			    -v w=$workers -v t=$median 'BEGIN {
+			if (mode == "weak") printf "%.4f %.4f\n", w*t0/t, t0/t
+			else printf "%.4f %.4f\n", w0*t0/t, w0*t0/t/w
+		    }')
+		    echo "$kernel,$mode,$size,$total,$p,$t,$workers,$RUNS,$median,$min,$stddev,$speedup,$efficiency"
+		done
+	    done
+	done
+    done
+}
+
+# Scaling tables of CSV (stdin)
+print_tables() {
+    awk -F, 'NR > 1 && $2 != "size" {
+	key = $1 " - " $2 " scaling, size " $3
+	if (key != last) {
+	    printf "\n%s\n%10s %10s %10s %14s %14s %10s %10s\n", key, "processes", "threads",
+		"workers", "median (s)", "stddev (s)", "speedup", "efficiency"
+	    last = key
+	}
+	printf "%10d %10d %10d %14.6e %14.6e %10.2f %10.2f\n", $5, $6, $7, $9, $11, $12, $13
+    }
+    NR > 1 && $2 == "size" {
+	if ($1 != last) {
+	    printf "\n%s - sizes (one thread per row)\n%10s %14s %14s\n", $1, "size", "median (s)", "stddev (s)"
+	    last = $1
+	}
+	printf "%10d %14.6e %14.6e\n", $3, $9, $11
+    }' >&2
+}
+
+# -----------------------------------------------------------------------------
+# Main program
+
+while getopts "t:p:n:m:w:r:o:b:qh" opt; do
+    case $opt in
+	t) THREADS=$OPTARG ;;
+	p) PROCS=$OPTARG ;;
+	n) SIZES=$OPTARG ;;
+	m) MODES=$OPTARG ;;
+	w) WARMUP=$OPTARG ;;
+	r) RUNS=$OPTARG ;;
+	o) OUTPUT=$OPTARG ;;
+	b) BUILD=$OPTARG ;;
+	q) TABLES=0 ;;
+	*) usage ;;
+    esac
+done
+shift $((OPTIND-1))
+[ "$RUNS" -ge 1 ] 2> /dev/null || usage
+
+KERNELS="$*"
+if [ -z "$KERNELS" ]; then
+    KERNELS="compute_pi list_minimum list_statistics drone min_distance"
+    command -v $MPICC > /dev/null && KERNELS="$KERNELS qsort_hypercube"
+fi
+
+mkdir -p "$BUILD"
+CSV=$(mktemp)
+trap 'rm -f "$CSV"' EXIT
+echo "kernel,mode,size,total_size,processes,threads,workers,runs,median_sec,min_sec,stddev_sec,speedup,efficiency" > "$CSV"
+for kernel in $KERNELS; do
+    echo "Building $kernel" >&2
+    build $kernel || { echo "Cannot build $kernel; skipped" >&2; continue; }
+    sweep $kernel >> "$CSV"
+done
+
+if [ -n "$OUTPUT" ]; then
+    cp "$CSV" "$OUTPUT"
+else
+    cat "$CSV"
+fi
+[ $TABLES -eq 1 ] && print_tables < "$CSV"
+exit 0
@@ -0,0 +1,209 @@
+// ----------------------------------------------------------------------------
+// Header file with a monotonic, overhead-corrected timer and named regions
+//
+// Times are read from CLOCK_MONOTONIC_RAW (CLOCK_MONOTONIC where it is
+// not defined): unlike CLOCK_REALTIME, it is not stepped or slewed by NTP,
+// so intervals cannot jump. Reading the clock takes time, and the start
+// and stop reads of an interval add about one read to it; this overhead is
+// calibrated once, as the median of TIMING_CALIBRATION_READS back-to-back
+// reads, and subtracted from every interval. Sub-millisecond intervals are
+// then not dominated by the timer itself.
+//
+// Regions are named intervals that may nest: timing_begin(name) starts a
+// region inside the innermost open region, timing_end() ends it. Regions
+// with the same name and parent are aggregated (count, total, minimum and
+// maximum), and timing_report prints them as a tree with the share of
+// each region in its parent. Regions are meant to be used by one thread
+// (the main thread, around thread creation and joins).
+//
+// Contains following routines
+//
+//    timing_read(&t)
+//	- read the clock into struct timespec t
+//
+//    timing_elapsed(&start, &stop)
+//	- seconds from start to stop, less the timer overhead
+//
+//    timing_overhead(), timing_resolution()
+//	- overhead of an interval and resolution of the clock, in seconds
+//
+//    timing_begin(name), timing_end()
+//	- start and end a region; timing_end returns its time in seconds
+//
+//    timing_report(fp)
+//	- print aggregates of all regions to fp
+//
+// Programs print the report when compiled with -DTIMING_REPORT=1.
+// All routines are static, so the header can be included by several files
+// of one program; each file then keeps its own regions.
+//
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef CLOCK_MONOTONIC_RAW
+#define TIMING_CLOCK		CLOCK_MONOTONIC_RAW
+#define TIMING_CLOCK_NAME	"CLOCK_MONOTONIC_RAW"
+#else
+#define TIMING_CLOCK		CLOCK_MONOTONIC
+#define TIMING_CLOCK_NAME	"CLOCK_MONOTONIC"
+#endif
+
+#define TIMING_CALIBRATION_READS 1001	// Back-to-back reads to calibrate overhead
+#define TIMING_MAX_REGIONS	64	// Maximum no. of distinct regions
+#define TIMING_MAX_DEPTH	16	// Maximum nesting of regions
+
+#ifndef TIMING_REPORT
+#define TIMING_REPORT 0			// Print region report if nonzero
+#endif
+
+struct timing_region {
+    const char * name;
+    int parent;				// Index of enclosing region; -1 at top level
+    int depth;				// Nesting depth; 0 at top level
+    long long count;			// Number of times the region was timed
+    int64_t total, min, max;		// Aggregate times (ns), overhead removed
+};
+
+static struct timing_region timing_regions[TIMING_MAX_REGIONS];
+static int timing_num_regions = 0;
+static int timing_stack[TIMING_MAX_DEPTH];		// Open regions, innermost last
+static struct timespec timing_starts[TIMING_MAX_DEPTH];	// Their start times
+static int timing_depth = 0;
+static int64_t timing_overhead_ns = -1;			// -1 until calibrated
+
+// ----------------------------------------------------------------------------
+static inline void timing_read(struct timespec * t) {
+    clock_gettime(TIMING_CLOCK, t);
+}
+
+static inline int64_t timing_diff_ns(const struct timespec * start, const struct timespec * stop) {
+    return (int64_t) (stop->tv_sec-start->tv_sec)*1000000000+(stop->tv_nsec-start->tv_nsec);
+}
+
+static int timing_compare_ns(const void * a, const void * b) {
+    int64_t x = *(const int64_t *) a, y = *(const int64_t *) b;
+    return (x > y)-(x < y);
+}
+
+// Overhead of an interval in ns: median difference of back-to-back reads
+static int64_t timing_calibrate(void) {
+    int64_t d[TIMING_CALIBRATION_READS];
+    struct timespec t0, t1;
+    int i;
+    if (timing_overhead_ns >= 0) return timing_overhead_ns;
+    timing_read(&t0);
+    for (i = 0; i < TIMING_CALIBRATION_READS; i++) {
+	timing_read(&t1);
+	d[i] = timing_diff_ns(&t0, &t1);
+	t0 = t1;
+    }
+    qsort(d, TIMING_CALIBRATION_READS, sizeof(int64_t), timing_compare_ns);
+    timing_overhead_ns = d[TIMING_CALIBRATION_READS/2];
+    return timing_overhead_ns;
+}
+
+// Interval in ns less the overhead; not negative
+static inline int64_t timing_corrected_ns(const struct timespec * start, const struct timespec * stop) {
+    int64_t ns = timing_diff_ns(start, stop)-timing_calibrate();
+    return (ns > 0) ? ns : 0;
+}
+
+// Seconds from start to stop, less the timer overhead
+static inline double timing_elapsed(const struct timespec * start, const struct timespec * stop) {
+    return 1.0e-9*timing_corrected_ns(start, stop);
+}
+
+static inline double timing_overhead(void) {
+    return 1.0e-9*timing_calibrate();
+}
+
+static inline double timing_resolution(void) {
+    struct timespec res;
+    clock_getres(TIMING_CLOCK, &res);
+    return res.tv_sec+1.0e-9*res.tv_nsec;
+}
+
+// ----------------------------------------------------------------------------
+// Start region name inside the innermost open region
+static inline void timing_begin(const char * name) {
+    int parent = (timing_depth > 0) ? timing_stack[timing_depth-1] : -1;
+    int r;
+    if (timing_depth == TIMING_MAX_DEPTH) {
+	printf("Regions nested deeper than %d. Aborting ...\n", TIMING_MAX_DEPTH);
+	exit(1);
+    }
+    timing_calibrate();		// Not inside the first timed region
+    for (r = 0; r < timing_num_regions; r++) {
+	if ((timing_regions[r].parent == parent) && (strcmp(timing_regions[r].name, name) == 0)) break;
+    }
+    if (r == timing_num_regions) {
+	if (r == TIMING_MAX_REGIONS) {
+	    printf("More than %d timing regions. Aborting ...\n", TIMING_MAX_REGIONS);
+	    exit(1);
+	}
+	timing_regions[r].name = name;
+	timing_regions[r].parent = parent;
+	timing_regions[r].depth = timing_depth;
+	timing_regions[r].count = 0;
+	timing_regions[r].total = timing_regions[r].max = 0;
+	timing_regions[r].min = INT64_MAX;
+	timing_num_regions++;
+    }
+    timing_stack[timing_depth] = r;
+    timing_read(&timing_starts[timing_depth++]);	// Last, to exclude the lookup
+}
+
+// End innermost open region; returns its time in seconds
+static inline double timing_end(void) {
+    struct timespec stop;
+    struct timing_region * region;
+    int64_t ns;
+    timing_read(&stop);				// First, to exclude the bookkeeping
+    if (timing_depth == 0) return 0.0;
+    timing_depth--;
+    region = &timing_regions[timing_stack[timing_depth]];
+    ns = timing_corrected_ns(&timing_starts[timing_depth], &stop);
+    region->count++;
+    region->total += ns;
+    if (ns < region->min) region->min = ns;
+    if (ns > region->max) region->max = ns;
+    return 1.0e-9*ns;
+}
+
+// Print regions with parent p, and their regions, depth first
+static void timing_report_children(FILE * fp, int p) {
+    struct timing_region * region;
+    int64_t parent_total;
+    int r;
+    for (r = 0; r < timing_num_regions; r++) {
+	region = &timing_regions[r];
+	if (region->parent != p) continue;
+	parent_total = (p >= 0) ? timing_regions[p].total : 0;
+	fprintf(fp, "%*s%-*s %10lld %14.9f %14.9f %14.9f %14.9f", 2*region->depth, "",
+		28-2*region->depth, region->name, region->count, 1.0e-9*region->total,
+		1.0e-9*region->total/region->count, 1.0e-9*region->min, 1.0e-9*region->max);
+	if (parent_total > 0) {
+	    fprintf(fp, " %7.2f%%\n", 100.0*region->total/parent_total);
+	} else {
+	    fprintf(fp, "\n");
+	}
+	timing_report_children(fp, r);
+    }
+}
+
+// Print aggregates of all regions (times in seconds)
+static inline void timing_report(FILE * fp) {
+    fprintf(fp, "Timer = %s, resolution = %.1e sec, overhead = %.1e sec (subtracted)\n",
+	    TIMING_CLOCK_NAME, timing_resolution(), timing_overhead());
+    fprintf(fp, "%-28s %10s %14s %14s %14s %14s %8s\n", "region", "count", "total", "mean",
+	    "min", "max", "parent");
+    timing_report_children(fp, -1);
+}
+
+#endif